@@ -0,0 +1,134 @@
+// Microbenchmark for NEC card formatting: the former stringstream-per-number
+// formatting against the std::to_chars path of DeckWriter, both on one
+// thread, and the whole deck written by NECGenerator with its GW cards
+// formatted on the pool.
+//
+// Usage: card-format-bench [wires]
+
+#include "deck_writer.h"
+#include "nec_generator.h"
+#include "material_database.h"
+#include "thread_pool.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace stl_to_eznec;
+
+namespace {
+
+// Square grid of roughly the requested number of wires
+WireGraph buildGrid(size_t wires) {
+    WireGraph grid;
+    grid.segmentLength = 0.1;
+    grid.wireRadius = 0.001;
+    size_t side = 1;
+    while (2 * side * (side + 1) < wires) side++;
+    for (size_t j = 0; j <= side; ++j) {
+        for (size_t i = 0; i <= side; ++i) {
+            grid.nodes.push_back(Point3D(0.1 * i - 12.345678, 0.1 * j + 0.0314159, 1.5 + 0.001 * ((i * 7 + j) % 13)));
+        }
+    }
+    for (size_t j = 0; j <= side; ++j) {
+        for (size_t i = 0; i <= side; ++i) {
+            uint32_t node = static_cast<uint32_t>(j * (side + 1) + i);
+            if (i < side) grid.edges.push_back({node, node + 1});
+            if (j < side) grid.edges.push_back({node, node + static_cast<uint32_t>(side + 1)});
+        }
+    }
+    return grid;
+}
+
+std::string streamCoordinate(double value) {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(6) << value;
+    return ss.str();
+}
+
+// GW cards as they were written before DeckWriter
+std::string streamCards(const WireGraph& grid) {
+    std::stringstream wires;
+    int wireTag = 1;
+    for (size_t e = 0; e < grid.edgeCount(); ++e) {
+        const Point3D& start = grid.edgeStart(e);
+        const Point3D& end = grid.edgeEnd(e);
+        wires << "GW " << wireTag << " " << grid.segmentCount(e) << " ";
+        wires << streamCoordinate(start.x) << " " << streamCoordinate(start.y) << " " << streamCoordinate(start.z) << " ";
+        wires << streamCoordinate(end.x) << " " << streamCoordinate(end.y) << " " << streamCoordinate(end.z) << " ";
+        wires << streamCoordinate(grid.radius(e)) << "\n";
+        wireTag++;
+    }
+    return wires.str();
+}
+
+// The same cards through DeckWriter's to_chars formatting, on this thread
+std::string toCharsCards(const WireGraph& grid) {
+    std::string text;
+    DeckWriter wires(text);
+    int wireTag = 1;
+    for (size_t e = 0; e < grid.edgeCount(); ++e) {
+        const Point3D& start = grid.edgeStart(e);
+        const Point3D& end = grid.edgeEnd(e);
+        wires.write("GW ", 3);
+        wires.writeInt(wireTag);
+        wires.put(' ');
+        wires.writeInt(grid.segmentCount(e));
+        for (double value : {start.x, start.y, start.z, end.x, end.y, end.z, grid.radius(e)}) {
+            wires.put(' ');
+            wires.writeFixed(value, 6);
+        }
+        wires.put('\n');
+        wireTag++;
+    }
+    wires.close();
+    return text;
+}
+
+double seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t wires = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    WireGraph grid = buildGrid(wires);
+    MaterialDatabase database;
+    const MaterialProperties& material = *database.getMaterial(0);
+    NECGenerator generator;
+    WireModel model = WireModel::buildStructureOnly(grid, material, "Benchmark");
+
+    auto start = std::chrono::steady_clock::now();
+    std::string reference = streamCards(grid);
+    double streamTime = seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    std::string formatted = toCharsCards(grid);
+    double toCharsTime = seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    DeckWriter deck;
+    if (!deck.open("/dev/null")) {
+        std::cerr << "Cannot open /dev/null\n";
+        return 1;
+    }
+    generator.writeNEC(deck, model);
+    deck.close();
+    double deckTime = seconds(start);
+
+    bool identical = formatted == reference;
+
+    double cards = static_cast<double>(grid.edgeCount());
+    std::cout << "=== Card Formatting ===\n";
+    std::cout << "GW cards: " << grid.edgeCount() << " (" << std::fixed << std::setprecision(1)
+              << reference.size() / 1048576.0 << " MB)\n";
+    std::cout << "stringstream per number, 1 thread: " << std::setprecision(0) << cards / streamTime << " cards/s\n";
+    std::cout << "to_chars, 1 thread:                " << cards / toCharsTime << " cards/s\n";
+    std::cout << "Formatting speedup: " << std::setprecision(1) << streamTime / toCharsTime << "x\n";
+    std::cout << "Whole deck (writeNEC, pool of " << ThreadPool::getInstance().getThreadCount() << "): "
+              << std::setprecision(0) << cards / deckTime << " cards/s\n";
+    std::cout << "Output identical: " << (identical ? "yes" : "NO") << "\n";
+    return identical ? 0 : 1;
+}
@@ -2,20 +2,28 @@
 
 #include <vector>
 #include <string>
+#include <algorithm>
 #include "geometry_utils.h"
+#include "mesh_topology.h"
 
 namespace stl_to_eznec {
 
 struct AntennaWire {
-    std::vector<Triangle> triangles;
+    ComponentView component;   // Facets of the wire, referenced in the shared mesh
     std::vector<Point3D> path;
     double radius;
     double length;
     Point3D startPoint;
     Point3D endPoint;
+    Point3D feedPoint;
+    double score;      // Ranking score, higher is more wire-like
+    int componentId;   // Connected component the wire was found in
     bool isDetected;
     
-    AntennaWire() : radius(0), length(0), isDetected(false) {}
+    AntennaWire() : radius(0), length(0), score(0), componentId(-1), isDetected(false) {}
+    
+    // Copy the wire's facets out of the shared mesh
+    std::vector<Triangle> getTriangles() const { return component.materialize(); }
 };
 
 class AntennaDetector {
@@ -25,6 +33,16 @@ public:
     // Detect antenna wire from STL triangles
     AntennaWire detectAntenna(const std::vector<Triangle>& triangles);
     
+    // Score every component in parallel and return all antennas, best first
+    std::vector<AntennaWire> detectAllAntennas(const std::vector<Triangle>& triangles);
+    
+    // Classify components in parallel; every wire-like one, in component order.
+    // Used for structural tubes as well, with wider diameter and length limits.
+    std::vector<AntennaWire> detectWires(const std::vector<ComponentView>& components) const;
+    
+    // Get antennas found by the last detectAllAntennas call
+    const std::vector<AntennaWire>& getAntennas() const { return antennas_; }
+    
     // Check if antenna was detected
     bool isAntennaDetected() const { return antenna_.isDetected; }
     
@@ -47,35 +65,54 @@ public:
     // Print antenna information
     void printAntennaInfo() const;
     
+    // Feed at the end touching the structure or the ground plane (z = 0),
+    // otherwise at mid-length
+    Point3D chooseFeedPoint(const std::vector<Point3D>& path, bool startAttached, bool endAttached) const;
+    
+    // How near a path end must come to a surface to count as attached. The
+    // end is the centre of the last ring, so a tube standing on a surface
+    // ends within a few radii of it.
+    static double attachDistance(double radius) { return std::max(4.0 * radius, 1e-3); }
+    
     // Set detection parameters
     void setMaxWireDiameter(double diameter) { maxWireDiameter_ = diameter; }
     void setMinWireLength(double length) { minWireLength_ = length; }
     void setMaxWireLength(double length) { maxWireLength_ = length; }
+    void setPathTolerance(double tolerance) { pathTolerance_ = tolerance; }
+    void setMinWireTriangles(size_t count) { minWireTriangles_ = count; }
     
     // Get detection parameters
     double getMaxWireDiameter() const { return maxWireDiameter_; }
     double getMinWireLength() const { return minWireLength_; }
     double getMaxWireLength() const { return maxWireLength_; }
+    double getPathTolerance() const { return pathTolerance_; }
+    size_t getMinWireTriangles() const { return minWireTriangles_; }
 
 private:
     AntennaWire antenna_;
+    std::vector<AntennaWire> antennas_;
     double maxWireDiameter_;  // Maximum diameter to consider as wire (default 1cm)
     double minWireLength_;    // Minimum length to consider as antenna (default 10cm)
     double maxWireLength_;    // Maximum length to consider as antenna (default 10m)
+    double pathTolerance_;    // Maximum path deviation when simplifying (default 1mm)
+    size_t minWireTriangles_; // Fewest facets a tube can have (default 6)
     
     // Detection algorithms
-    std::vector<std::vector<Triangle>> findWireLikeComponents(const std::vector<Triangle>& triangles);
-    bool isWireLikeComponent(const std::vector<Triangle>& component);
-    std::vector<Point3D> extractWirePath(const std::vector<Triangle>& component);
-    double calculateWireRadius(const std::vector<Triangle>& component);
-    double calculateWireLength(const std::vector<Point3D>& path);
-    bool isReasonableAntennaLength(double length);
-    bool isReasonableAntennaRadius(double radius);
+    std::vector<ComponentView> findWireLikeComponents(const std::vector<Triangle>& triangles);
+    bool passesQuickRejection(const ComponentView& component) const;
+    AntennaWire evaluateComponent(const ComponentView& component) const;
+    bool isWireLikeComponent(const ComponentView& component) const;
+    std::vector<Point3D> extractWirePath(const ComponentView& component);
+    double calculateWireRadius(const ComponentView& component);
+    double calculateWireLength(const std::vector<Point3D>& path) const;
+    bool isReasonableAntennaLength(double length) const;
+    bool isReasonableAntennaRadius(double radius) const;
+    void placeFeedPoints(std::vector<AntennaWire>& wires) const;
     
     // Helper functions
-    std::vector<std::vector<Triangle>> separateConnectedComponents(const std::vector<Triangle>& triangles);
+    std::vector<ComponentView> separateConnectedComponents(const std::vector<Triangle>& triangles);
     bool areTrianglesConnected(const Triangle& t1, const Triangle& t2, double tolerance = 1e-6);
-    std::vector<Point3D> simplifyPath(const std::vector<Point3D>& path, double tolerance = 1e-3);
+    std::vector<Point3D> simplifyPath(const std::vector<Point3D>& path, double tolerance = 1e-3) const;
 };
 
 } // namespace stl_to_eznec
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "geometry_utils.h"
+#include "mesh_topology.h"
+
+namespace stl_to_eznec {
+
+// Principal axes and extents derived from a covariance matrix
+struct OrientedExtents {
+    Point3D center;
+    std::array<Point3D, 3> axes;       // Unit eigenvectors, largest variance first
+    std::array<double, 3> variances;   // Eigenvalues, descending
+    std::array<double, 3> extents;     // Full extent along each axis, sqrt(12 * variance)
+    double length;                     // Extent along the principal axis
+    double crossSectionDiameter;       // 2 * sqrt(minor variances); exact for round tubes
+    double aspectRatio;                // length / crossSectionDiameter
+
+    OrientedExtents() : variances{0, 0, 0}, extents{0, 0, 0}, length(0), crossSectionDiameter(0), aspectRatio(0) {}
+
+    const Point3D& principalAxis() const { return axes[0]; }
+};
+
+// Single-pass weighted mean and 3x3 covariance (Chan et al. update).
+// Accumulators built on separate chunks or threads can be merged exactly.
+class CovarianceAccumulator {
+public:
+    CovarianceAccumulator();
+
+    // Add a point mass
+    void addPoint(const Point3D& point, double weight = 1.0);
+
+    // Add a triangle as a uniform surface density (weight = area)
+    void addTriangle(const Triangle& triangle);
+    void addTriangle(const Point3D& a, const Point3D& b, const Point3D& c);
+
+    // Combine with an accumulator built over a disjoint set of samples
+    void merge(const CovarianceAccumulator& other);
+
+    double getWeight() const { return weight_; }
+    Point3D getMean() const { return mean_; }
+    bool isEmpty() const { return weight_ <= 0.0; }
+
+    // Covariance matrix (row-major, symmetric)
+    std::array<double, 9> getCovariance() const;
+
+    // Eigen-decomposition of the covariance
+    OrientedExtents getOrientedExtents() const;
+
+    // Accumulate a triangle range, splitting large inputs across the thread pool
+    static CovarianceAccumulator fromTriangles(const std::vector<Triangle>& triangles);
+
+    // Accumulate the faces of a component view in place
+    static CovarianceAccumulator fromComponent(const ComponentView& component);
+
+    // Symmetric 3x3 eigen-decomposition by cyclic Jacobi rotations
+    static void eigenDecompose(const std::array<double, 9>& matrix, std::array<double, 3>& eigenvalues, std::array<Point3D, 3>& eigenvectors);
+
+private:
+    double weight_;
+    Point3D mean_;
+    // Weighted sum of centered outer products: xx, xy, xz, yy, yz, zz
+    std::array<double, 6> scatter_;
+
+    void addMoments(double weight, const Point3D& mean, const std::array<double, 6>& scatter);
+};
+
+} // namespace stl_to_eznec
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "wire_model.h"
+#include "deck_writer.h"
+
+namespace stl_to_eznec {
+
+// Card-by-card serialization of a WireModel, shared by the NEC and EZ
+// generators. The two formats take the same header, GW/GM/GR/GX geometry,
+// loads, sources, ground and frequency cards; they differ only in how
+// surface patches are written.
+class DeckSerializer {
+public:
+    enum class PatchPolicy {
+        SurfacePatches,   // SP/SC cards after every wire (NEC)
+        StandInWires      // The stand-in wire grid, tagged after the wires (EZ)
+    };
+
+    explicit DeckSerializer(PatchPolicy patchPolicy);
+
+    // Write a complete deck
+    void write(DeckWriter& out, const WireModel& model) const;
+
+    // Cards the deck will take, to size the writer's buffer
+    size_t cardCount(const WireModel& model) const;
+
+    // Set output options
+    void setIncludeComments(bool include) { includeComments_ = include; }
+    void setIncludePattern(bool include) { includePattern_ = include; }
+    void setIncludeCurrent(bool include) { includeCurrent_ = include; }
+
+    PatchPolicy getPatchPolicy() const { return patchPolicy_; }
+
+private:
+    // Decimal places of coordinates, radii and angles
+    static constexpr int COORDINATE_PRECISION = 6;
+
+    PatchPolicy patchPolicy_;
+    bool includeComments_;
+    bool includePattern_;
+    bool includeCurrent_;
+
+    // Generate file header
+    std::string generateHeader(const WireModel& model) const;
+    std::string generateStructureOnlyHeader(const std::string& modelName, const MaterialProperties& material) const;
+
+    // Write geometry section
+    void writeGeometry(DeckWriter& out, const WireModel& model) const;
+
+    // Write wires, each replicated prototype followed by its GM/GR card
+    void writeWires(DeckWriter& out, const WireModel& model) const;
+
+    // Write surface patches
+    void writeSurfacePatches(DeckWriter& out, const IndexedMesh& patches) const;
+
+    // Write loads
+    void writeLoads(DeckWriter& out, const std::vector<NECLoad>& loads) const;
+
+    // Write excitation
+    void writeExcitations(DeckWriter& out, const std::vector<NECExcitation>& excitations) const;
+
+    // Write ground
+    void writeGround(DeckWriter& out, const WireModel& model) const;
+
+    // Generate frequency
+    std::string generateFrequency(const FrequencyCalculator& frequency) const;
+
+    // Helper functions
+    void writeWire(DeckWriter& out, const NECDeck& wires, size_t index) const;
+    std::string getMaterialComment(const MaterialProperties& material) const;
+};
+
+} // namespace stl_to_eznec
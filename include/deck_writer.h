@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <functional>
+
+namespace stl_to_eznec {
+
+// Buffered output for NEC/EZ decks. Cards are appended to one reusable
+// buffer that is flushed to a file descriptor (or a string) whenever it
+// fills, so a deck is never held in memory as a whole. The buffer keeps its
+// size between files, so one writer can produce the NEC and EZ decks in turn.
+class DeckWriter {
+public:
+    // Typical card length, used to size the buffer from a card estimate
+    static constexpr size_t CARD_BYTES = 96;
+
+    explicit DeckWriter(size_t capacity = 1 << 20);
+    // Flushes into target instead of a file
+    explicit DeckWriter(std::string& target, size_t capacity = 64 << 10);
+    ~DeckWriter();
+
+    DeckWriter(const DeckWriter&) = delete;
+    DeckWriter& operator=(const DeckWriter&) = delete;
+
+    // Truncates or creates the file; an open file is closed first
+    bool open(const std::string& filename);
+    // Flushes and closes; false when any write failed
+    bool close();
+    bool isOpen() const { return fd_ >= 0 || target_ != nullptr; }
+    bool good() const { return !failed_; }
+
+    // Grows the buffer to hold about this many cards, between 64 KB and 16 MB
+    void reserveCards(size_t cards);
+
+    void write(const char* data, size_t length);
+    void write(const std::string& text) { write(text.data(), text.size()); }
+    void put(char c) {
+        if (used_ == buffer_.size()) flush();
+        buffer_[used_++] = c;
+    }
+
+    // Numbers formatted in place with std::to_chars, matching the stream
+    // output of std::fixed / std::scientific at the same precision
+    void writeInt(long long value);
+    void writeFixed(double value, int precision);
+    void writeScientific(double value, int precision);
+
+    // The same formatting into a caller's buffer; returns the length, or 0
+    // when it does not fit
+    static size_t formatFixed(char* out, size_t size, double value, int precision);
+    static size_t formatScientific(char* out, size_t size, double value, int precision);
+    static std::string fixed(double value, int precision);
+    static std::string scientific(double value, int precision);
+
+    // Formats items [0, count) on the thread pool, one batch at a time:
+    // format(chunk, begin, end) writes a range into the chunk's own buffer,
+    // and the chunks are appended in order, so the output does not depend
+    // on the thread count. Small counts are formatted here directly.
+    void writeChunks(size_t count, const std::function<void(DeckWriter&, size_t, size_t)>& format,
+                     size_t batchSize = 1 << 16);
+
+    // Hands the buffered bytes to the file or string
+    void flush();
+
+    size_t getCapacity() const { return buffer_.size(); }
+    size_t getBytesWritten() const { return bytesWritten_ + used_; }
+
+private:
+    std::vector<char> buffer_;
+    size_t used_;
+    size_t bytesWritten_;
+    int fd_;
+    std::string* target_;
+    bool failed_;
+    std::vector<std::string> chunks_;   // Per-chunk text of writeChunks, kept for reuse
+
+    void sink(const char* data, size_t length);
+    void writeNumber(double value, int precision, bool exponential);
+};
+
+} // namespace stl_to_eznec
@@ -6,6 +6,10 @@
 #include "material_database.h"
 #include "frequency_calculator.h"
 #include "antenna_detector.h"
+#include "wire_graph.h"
+#include "wire_model.h"
+#include "deck_writer.h"
+#include "deck_serializer.h"
 
 namespace stl_to_eznec {
 
@@ -25,6 +29,18 @@ public:
         const WaterProperties* water = nullptr
     );
     
+    // Generate EZ file from a remeshed wire grid
+    std::string generateEZ(
+        const WireGraph& structure,
+        const MaterialProperties& material,
+        const FrequencyCalculator& frequency,
+        const AntennaWire& antenna,
+        const std::string& modelName = "STL Model",
+        bool hasAntenna = true,
+        double waterlineHeight = 0.0,
+        const WaterProperties* water = nullptr
+    );
+    
     // Generate EZ file without antenna
     std::string generateEZStructureOnly(
         const std::vector<Triangle>& triangles,
@@ -32,68 +48,65 @@ public:
         const std::string& modelName = "STL Model"
     );
     
-    // Set output options
-    void setIncludeComments(bool include) { includeComments_ = include; }
-    void setIncludePattern(bool include) { includePattern_ = include; }
-    
-    // Get generated EZ content
-    const std::string& getEZContent() const { return ezContent_; }
-
-private:
-    std::string ezContent_;
-    bool includeComments_;
-    bool includePattern_;
-    
-    // Generate file header
-    std::string generateHeader(const std::string& modelName, const FrequencyCalculator& frequency);
-    
-    // Generate geometry section
-    std::string generateGeometry(
-        const std::vector<Triangle>& triangles,
+    std::string generateEZStructureOnly(
+        const WireGraph& structure,
         const MaterialProperties& material,
-        const AntennaWire& antenna,
-        bool hasAntenna
+        const std::string& modelName = "STL Model"
     );
     
-    // Generate wire definitions
-    std::string generateWires(
-        const std::vector<Triangle>& triangles,
+    // Generate EZ file from a prepared model
+    std::string generateEZ(const WireModel& model);
+    
+    // Stream the deck card by card into an open writer instead of building
+    // it as a string; the writer's buffer is first sized from the card count
+    void writeEZ(DeckWriter& out, const WireModel& model);
+    
+    void writeEZ(
+        DeckWriter& out,
+        const WireGraph& structure,
         const MaterialProperties& material,
+        const FrequencyCalculator& frequency,
         const AntennaWire& antenna,
-        bool hasAntenna
+        const std::string& modelName = "STL Model",
+        bool hasAntenna = true,
+        double waterlineHeight = 0.0,
+        const WaterProperties* water = nullptr
     );
     
-    // Generate antenna wire
-    std::string generateAntennaWire(const AntennaWire& antenna, int& wireTag);
-    
-    // Generate structure wires
-    std::string generateStructureWires(
-        const std::vector<Triangle>& triangles,
+    void writeEZStructureOnly(
+        DeckWriter& out,
+        const WireGraph& structure,
         const MaterialProperties& material,
-        int& wireTag
+        const std::string& modelName = "STL Model"
     );
     
-    // Generate excitation
-    std::string generateExcitation(const AntennaWire& antenna);
-    
-    // Generate ground
-    std::string generateGround(double waterlineHeight, const WaterProperties* water);
-    
-    // Generate frequency
-    std::string generateFrequency(const FrequencyCalculator& frequency);
-    
-    // Generate pattern
-    std::string generatePattern();
+    // Set output options
+    void setIncludeComments(bool include) { serializer_.setIncludeComments(include); }
+    void setIncludePattern(bool include) { serializer_.setIncludePattern(include); }
     
-    // Helper functions
-    int calculateSegments(double length, double gridSpacing);
-    std::string formatCoordinate(double value);
-    std::string formatScientific(double value);
-    std::string getMaterialComment(const MaterialProperties& material);
+    // Get generated EZ content
+    const std::string& getEZContent() const { return ezContent_; }
+
+private:
+    std::string ezContent_;
+    DeckSerializer serializer_;   // Patches as their stand-in wire grid
     
-    // EZ-specific formatting
-    std::string formatEZCoordinate(double value);
-    std::string formatEZScientific(double value);
+    // Model of a wire graph
+    WireModel buildModel(
+        const WireGraph& structure,
+        const MaterialProperties& material,
+        const FrequencyCalculator& frequency,
+        const AntennaWire& antenna,
+        const std::string& modelName,
+        bool hasAntenna,
+        double waterlineHeight,
+        const WaterProperties* water
+    ) const;
+    WireModel buildStructureOnlyModel(
+        const WireGraph& structure,
+        const MaterialProperties& material,
+        const std::string& modelName
+    ) const;
 };
 
 } // namespace stl_to_eznec
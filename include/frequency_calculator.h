@@ -23,12 +23,19 @@ public:
     // Get standard accuracy grid spacing (λ/10) in meters  
     double getStandardAccuracyGridSpacing() const { return wavelength_ / 10.0; }
     
+    // Get coarsest usable grid spacing (λ/5) in meters, for structure far from the antenna
+    double getCoarseGridSpacing() const { return wavelength_ / 5.0; }
+    
     // Get recommended grid spacing (5cm for amateur radio) in meters
     double getRecommendedGridSpacing() const { return 0.05; }
     
+    // Get wire path simplification tolerance (fraction of λ) in meters
+    double getPathSimplificationTolerance(double fraction = 0.005) const { return wavelength_ * fraction; }
+    
     // Get grid spacing in cm
     double getHighAccuracyGridSpacingCm() const { return getHighAccuracyGridSpacing() * 100.0; }
     double getStandardAccuracyGridSpacingCm() const { return getStandardAccuracyGridSpacing() * 100.0; }
+    double getCoarseGridSpacingCm() const { return getCoarseGridSpacing() * 100.0; }
     double getRecommendedGridSpacingCm() const { return getRecommendedGridSpacing() * 100.0; }
     
     // Calculate number of segments for a wire of given length
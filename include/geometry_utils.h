@@ -146,6 +146,8 @@ public:
     // Enhanced STL processing methods
     static std::vector<Point3D> extractWirePathAdvanced(const std::vector<Triangle>& triangles);
     static std::vector<Point3D> simplifyWirePath(const std::vector<Point3D>& path, double tolerance = 1e-3);
+    static std::vector<Point3D> simplifyWirePathDouglasPeucker(const std::vector<Point3D>& path, double tolerance);
+    static double pointSegmentDistance(const Point3D& point, const Point3D& start, const Point3D& end);
     static double calculateWireLength(const std::vector<Point3D>& path);
     static bool isReasonableWireGeometry(const std::vector<Triangle>& triangles);
     static std::vector<Point3D> findWireEndpoints(const std::vector<Triangle>& triangles);
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include "geometry_utils.h"
+#include "mesh_topology.h"
+
+namespace stl_to_eznec {
+
+// A component and its copies written once and replicated by a GM card.
+// Copy k is the prototype stepped k times: rotated about the z axis, then
+// translated.
+struct InstanceRun {
+    IndexedMesh prototype;
+    int copies;                 // Copies beyond the prototype
+    double rotateZDegrees;      // Per-step rotation
+    Point3D translation;        // Per-step translation after the rotation
+
+    InstanceRun() : copies(0), rotateZDegrees(0) {}
+};
+
+// Structure split into replicated runs and everything else
+struct InstanceSet {
+    IndexedMesh remainder;              // Faces written as they are
+    std::vector<InstanceRun> runs;
+    size_t replicatedComponents;        // Components covered by runs, prototypes included
+
+    InstanceSet() : replicatedComponents(0) {}
+};
+
+// Finds repeated substructures (masts, railing posts, array elements).
+// Components are fingerprinted by face and vertex count, surface area and
+// the eigenvalues of their area-weighted second moments, which do not change
+// under rotation or translation. Matching fingerprints are confirmed by
+// mapping every vertex through a rotation about z plus a translation. Equal
+// translation steps and complete rings about a vertical axis become runs,
+// since GM applies the same step to each copy in turn.
+class InstanceDetector {
+public:
+    InstanceDetector();
+
+    // Vertex match tolerance as a fraction of the component size
+    void setTolerance(double relativeTolerance) { tolerance_ = relativeTolerance; }
+    double getTolerance() const { return tolerance_; }
+
+    // Components smaller than this (in meters) are left in the remainder
+    void setMinExtent(double extent) { minExtent_ = extent; }
+    double getMinExtent() const { return minExtent_; }
+
+    InstanceSet detect(const IndexedMesh& mesh) const;
+
+private:
+    double tolerance_;
+    double minExtent_;
+};
+
+} // namespace stl_to_eznec
@@ -111,8 +111,9 @@ public:
     
     STLFileStats getFileStats(const std::string& filename);
     
-    // Memory-efficient antenna detection
-    AntennaWire detectAntennaStreaming(const std::string& filename);
+    // Memory-efficient antenna detection; the centerline is simplified to
+    // pathTolerance, as AntennaDetector::setPathTolerance does
+    AntennaWire detectAntennaStreaming(const std::string& filename, double pathTolerance = 1e-3);
     
 private:
     MemoryManager memoryManager_;
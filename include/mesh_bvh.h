@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "geometry_utils.h"
+#include "mesh_topology.h"
+
+namespace stl_to_eznec {
+
+// Closest facet found by a query; face -1 = none
+struct BVHHit {
+    int64_t face;
+    double distance;
+    Point3D point;
+
+    BVHHit() : face(-1), distance(0) {}
+
+    bool found() const { return face >= 0; }
+};
+
+// Bounding volume hierarchy over the facets of an indexed mesh. Nodes are
+// split with a binned surface-area heuristic and stored flat, with the left
+// child right after its parent. The mesh must outlive the tree;
+// queries are read-only and safe to run from many threads at once.
+class MeshBVH {
+public:
+    explicit MeshBVH(const IndexedMesh& mesh);
+
+    // Nearest facet along the ray within maxDistance; direction must be unit length
+    BVHHit intersect(const Point3D& origin, const Point3D& direction, double maxDistance,
+                     int64_t ignoreFace = -1) const;
+
+    // True if any facet lies on the ray within maxDistance; stops at the first one found
+    bool occluded(const Point3D& origin, const Point3D& direction, double maxDistance,
+                  int64_t ignoreFace = -1) const;
+
+    // Closest point on any facet within maxDistance of the point
+    BVHHit nearest(const Point3D& point, double maxDistance = 1e30) const;
+
+    size_t nodeCount() const { return nodes_.size(); }
+    const IndexedMesh& mesh() const { return *mesh_; }
+
+    // Bounding box of the whole mesh
+    Point3D getMin() const { return nodes_.empty() ? Point3D() : nodes_[0].low; }
+    Point3D getMax() const { return nodes_.empty() ? Point3D() : nodes_[0].high; }
+
+private:
+    struct Node {
+        Point3D low, high;
+        uint32_t first;     // Leaf: first entry in faces_; interior: right child
+        uint32_t count;     // Leaf face count; 0 = interior
+    };
+
+    const IndexedMesh* mesh_;
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> faces_;
+
+    static constexpr uint32_t LEAF_SIZE = 4;
+
+    uint32_t build(std::vector<Point3D>& centroids, uint32_t begin, uint32_t end);
+
+    // Shared traversal; anyHit returns on the first facet found
+    BVHHit traverse(const Point3D& origin, const Point3D& direction, double maxDistance,
+                    int64_t ignoreFace, bool anyHit) const;
+};
+
+} // namespace stl_to_eznec
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include "geometry_utils.h"
+#include "mesh_topology.h"
+#include "frequency_calculator.h"
+
+namespace stl_to_eznec {
+
+// What a cleanup pass removed
+struct CleanupReport {
+    size_t inputFacets;
+    size_t degenerateFacets;       // Repeated vertices or zero area
+    size_t duplicateFacets;        // Same three vertices as an earlier facet
+    size_t smallComponents;        // Parts below the minimum feature size
+    size_t smallComponentFacets;
+    size_t outputFacets;
+
+    CleanupReport() : inputFacets(0), degenerateFacets(0), duplicateFacets(0), smallComponents(0),
+                      smallComponentFacets(0), outputFacets(0) {}
+};
+
+// Pre-pass that drops facets carrying no electrical information: degenerate
+// and duplicate facets, and whole components (rivets, bolts, embossed text)
+// whose oriented extent is below a wavelength-relative size. Facet tests and
+// component moments run in parallel on the shared thread pool. Thin but
+// real facets are kept; collapseSlivers repairs needles once the tubes,
+// which are faceted with them, have been replaced by wires.
+class MeshCleaner {
+public:
+    explicit MeshCleaner(double minFeatureSize = 0.0);
+
+    // Components smaller than lambda / divisions are removed
+    static MeshCleaner fromFrequency(const FrequencyCalculator& frequency, double divisions = 20.0);
+
+    IndexedMesh clean(const IndexedMesh& mesh, CleanupReport* report = nullptr) const;
+
+    // Welds the short edge of every needle-shaped sliver at its midpoint, so
+    // the sliver and its neighbour across that edge vanish without leaving a
+    // hole. A needle is a sliver whose shortest edge is below the square
+    // root of the sliver ratio times its longest edge.
+    IndexedMesh collapseSlivers(const IndexedMesh& mesh, size_t* collapsed = nullptr) const;
+
+    // Largest oriented extent below which a component is culled; 0 = keep all
+    void setMinFeatureSize(double size) { minFeatureSize_ = size; }
+    double getMinFeatureSize() const { return minFeatureSize_; }
+
+    // Facets whose height is below this fraction of their longest edge are slivers;
+    // clean keeps them, collapseSlivers welds the needles among them
+    void setSliverRatio(double ratio) { sliverRatio_ = ratio; }
+    double getSliverRatio() const { return sliverRatio_; }
+
+    static void printReport(const CleanupReport& report);
+
+private:
+    double minFeatureSize_;
+    double sliverRatio_;
+};
+
+} // namespace stl_to_eznec
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include "geometry_utils.h"
+#include "mesh_topology.h"
+#include "frequency_calculator.h"
+
+namespace stl_to_eznec {
+
+// Plane-distance error quadric: symmetric 4x4 stored as its upper triangle
+struct Quadric {
+    std::array<double, 10> q;   // a00 a01 a02 a03 a11 a12 a13 a22 a23 a33
+
+    Quadric() : q{0, 0, 0, 0, 0, 0, 0, 0, 0, 0} {}
+
+    // Area-weighted plane through point with unit normal
+    static Quadric fromPlane(const Point3D& normal, const Point3D& point, double weight);
+
+    Quadric& operator+=(const Quadric& other);
+
+    // Sum of weighted squared distances from the planes
+    double evaluate(const Point3D& point) const;
+
+    // Point of least error; false when the planes do not pin it down
+    bool minimize(Point3D& point) const;
+};
+
+// Quadric-error-metric (Garland-Heckbert) edge-collapse decimator.
+// Only edges shorter than the minimum edge length are collapsed, cheapest
+// first, until the face target is reached. Vertices on sharp, open or
+// non-manifold edges stay pinned, so outlines and creases are preserved.
+// Slabs of the mesh are decimated in parallel with their shared rims frozen;
+// a final pass over the whole mesh then finishes the rims.
+class MeshDecimator {
+public:
+    MeshDecimator();
+
+    // Collapse edges shorter than lambda / divisions
+    static MeshDecimator fromFrequency(const FrequencyCalculator& frequency, double divisions = 20.0);
+
+    IndexedMesh decimate(const IndexedMesh& mesh) const;
+    std::vector<Triangle> decimate(const std::vector<Triangle>& triangles) const;
+
+    // 0 = no face target; stop only when no short edge is left
+    void setTargetFaceCount(size_t count) { targetFaceCount_ = count; }
+    size_t getTargetFaceCount() const { return targetFaceCount_; }
+
+    // Edges at least this long are never collapsed; 0 = no limit
+    void setMinEdgeLength(double length) { minEdgeLength_ = length; }
+    double getMinEdgeLength() const { return minEdgeLength_; }
+
+    // Dihedral angle in degrees above which an edge counts as a feature
+    void setFeatureAngle(double degrees) { featureAngle_ = degrees; }
+    double getFeatureAngle() const { return featureAngle_; }
+
+    // Number of spatial slabs decimated concurrently; 0 = one per pool thread
+    void setPartitionCount(unsigned count) { partitionCount_ = count; }
+    unsigned getPartitionCount() const { return partitionCount_; }
+
+private:
+    size_t targetFaceCount_;
+    double minEdgeLength_;
+    double featureAngle_;
+    unsigned partitionCount_;
+};
+
+} // namespace stl_to_eznec
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <memory>
+#include "geometry_utils.h"
+#include "wire_graph.h"
+
+namespace stl_to_eznec {
+
+// Triangle mesh with shared (welded) vertices
+struct IndexedMesh {
+    std::vector<Point3D> vertices;
+    std::vector<std::array<uint32_t, 3>> faces;
+
+    size_t vertexCount() const { return vertices.size(); }
+    size_t faceCount() const { return faces.size(); }
+
+    Triangle triangle(size_t face) const {
+        const auto& f = faces[face];
+        return Triangle(vertices[f[0]], vertices[f[1]], vertices[f[2]]);
+    }
+};
+
+// Connected components stored in CSR form: the faces of component c are
+// faces[offsets[c]] .. faces[offsets[c + 1] - 1]
+struct ComponentTable {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> faces;
+    std::vector<uint32_t> faceComponent;  // Component id of every mesh face
+
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    size_t faceCount(size_t component) const { return offsets[component + 1] - offsets[component]; }
+};
+
+// Indexed mesh together with its component table, shared by detection results
+struct ComponentMesh {
+    IndexedMesh mesh;
+    ComponentTable components;
+};
+
+// Zero-copy reference to one component: a range of the CSR face index array
+struct ComponentView {
+    std::shared_ptr<const ComponentMesh> source;
+    uint32_t componentId;
+    uint32_t offset;
+    uint32_t count;
+
+    ComponentView() : componentId(0), offset(0), count(0) {}
+    ComponentView(std::shared_ptr<const ComponentMesh> source, uint32_t componentId);
+
+    bool empty() const { return !source || count == 0; }
+    size_t size() const { return count; }
+
+    // Face indices into source->mesh
+    const uint32_t* begin() const { return source->components.faces.data() + offset; }
+    const uint32_t* end() const { return begin() + count; }
+
+    const IndexedMesh& mesh() const { return source->mesh; }
+    Triangle triangle(size_t i) const { return source->mesh.triangle(begin()[i]); }
+
+    // Copy the faces out as triangles; only for callers that really need them
+    std::vector<Triangle> materialize() const;
+
+    // Unique vertex ids used by the component
+    std::vector<uint32_t> vertexIds() const;
+};
+
+// Uniform-grid spatial hash for point proximity queries
+class SpatialHash {
+public:
+    explicit SpatialHash(double cellSize);
+
+    void reserve(size_t count);
+    void insert(const Point3D& point, uint32_t id);
+
+    // Return the id of an inserted point within tolerance of the query, or -1
+    int64_t findNear(const Point3D& point, double tolerance) const;
+
+    // Return the id of the nearest inserted point within tolerance, the
+    // lowest id on ties, or -1
+    int64_t findNearest(const Point3D& point, double tolerance) const;
+
+    double getCellSize() const { return cellSize_; }
+    size_t size() const { return points_.size(); }
+
+private:
+    double cellSize_;
+    std::unordered_map<uint64_t, uint32_t> heads_;  // Cell key -> first entry
+    std::vector<uint32_t> next_;                    // Per-entry chain link
+    std::vector<Point3D> points_;
+    std::vector<uint32_t> ids_;
+
+    static constexpr uint32_t NO_ENTRY = 0xFFFFFFFFu;
+
+    int64_t cellCoordinate(double value) const;
+    static uint64_t cellKey(int64_t ix, int64_t iy, int64_t iz);
+};
+
+class MeshTopology {
+public:
+    // Weld coincident triangle vertices into an indexed mesh
+    static IndexedMesh buildIndexedMesh(const std::vector<Triangle>& triangles, double weldTolerance = 1e-6);
+
+    // Group faces that share vertices into connected components
+    static ComponentTable findConnectedComponents(const IndexedMesh& mesh);
+
+    // Weld and split into components once; views into the result share it
+    static std::shared_ptr<const ComponentMesh> buildComponentMesh(const std::vector<Triangle>& triangles, double weldTolerance = 1e-6);
+
+    // One view per component of a shared mesh
+    static std::vector<ComponentView> componentViews(const std::shared_ptr<const ComponentMesh>& source);
+
+    // Keep the part of the surface where coordinate[axis] >= offset. Facets
+    // crossing the plane are split; cut points land exactly on the plane and
+    // are shared by both facets on the cut edge. Classification and splitting
+    // run in parallel; the output order does not depend on the thread count.
+    static IndexedMesh clipToHalfSpace(const IndexedMesh& mesh, int axis, double offset);
+
+    // Every distinct mesh edge once, in first-seen order, as a wire graph
+    static WireGraph buildEdgeGraph(const IndexedMesh& mesh);
+
+    // The listed faces as a standalone mesh with only the vertices they use
+    static IndexedMesh extractFaces(const IndexedMesh& mesh, const uint32_t* begin, const uint32_t* end);
+
+    // Copy the faces of one component out as triangles
+    static std::vector<Triangle> extractComponent(const IndexedMesh& mesh, const ComponentTable& components, size_t component);
+};
+
+} // namespace stl_to_eznec
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include "geometry_utils.h"
+
+namespace stl_to_eznec {
+
+struct NECWire {
+    int tag;
+    int segments;
+    Point3D start;
+    Point3D end;
+    double radius;
+
+    NECWire() : tag(0), segments(0), radius(0) {}
+    NECWire(int tag, int segments, const Point3D& start, const Point3D& end, double radius)
+        : tag(tag), segments(segments), start(start), end(end), radius(radius) {}
+};
+
+// Wire totals and extremes of a deck; the thin-wire approximation wants
+// segments several radii long
+struct DeckStatistics {
+    size_t wires;
+    size_t segments;
+    double totalLength;
+    double minSegmentLength;
+    double maxSegmentLength;
+    double minRadius;
+    double maxRadius;
+    double minLengthToRadius;   // Shortest segment over its wire radius
+    Point3D minCorner;
+    Point3D maxCorner;
+
+    DeckStatistics() : wires(0), segments(0), totalLength(0), minSegmentLength(0), maxSegmentLength(0), minRadius(0),
+                       maxRadius(0), minLengthToRadius(0) {}
+};
+
+// Columnar wire table: tags, segment counts, endpoints and radii in
+// parallel arrays, so bulk passes (renumbering, reordering, filtering,
+// statistics) touch only the fields they need. NECWire is the row type.
+struct NECDeck {
+    std::vector<int> tags;
+    std::vector<int> segments;
+    std::vector<Point3D> starts;
+    std::vector<Point3D> ends;
+    std::vector<double> radii;
+
+    size_t size() const { return tags.size(); }
+    bool empty() const { return tags.empty(); }
+
+    void reserve(size_t count);
+    void resize(size_t count);
+    void clear();
+
+    void push_back(const NECWire& wire);
+    void set(size_t index, const NECWire& wire);
+    NECWire wire(size_t index) const {
+        return NECWire(tags[index], segments[index], starts[index], ends[index], radii[index]);
+    }
+    void append(const NECDeck& other);
+
+    // Tag the wires firstTag, firstTag + 1, ... in array order
+    void renumber(int firstTag = 1);
+
+    // Reorder wires [begin, end) along a Morton curve through their
+    // midpoints, so neighbouring wires sit close in the arrays. Tags move
+    // with their wires; returns the old index of each wire in the range.
+    std::vector<uint32_t> sortByLocality(size_t begin, size_t end);
+    std::vector<uint32_t> sortByLocality() { return sortByLocality(0, size()); }
+
+    // Keep the wires for which keep(index) holds, in order; returns the
+    // number removed
+    size_t filter(const std::function<bool(size_t)>& keep);
+
+    DeckStatistics statistics() const;
+    static void printStatistics(const DeckStatistics& statistics);
+};
+
+} // namespace stl_to_eznec
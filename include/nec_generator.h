@@ -6,31 +6,14 @@
 #include "material_database.h"
 #include "frequency_calculator.h"
 #include "antenna_detector.h"
+#include "wire_graph.h"
+#include "wire_model.h"
+#include "mesh_topology.h"
+#include "deck_writer.h"
+#include "deck_serializer.h"
 
 namespace stl_to_eznec {
 
-struct NECWire {
-    int tag;
-    int segments;
-    Point3D start;
-    Point3D end;
-    double radius;
-    
-    NECWire(int tag, int segments, const Point3D& start, const Point3D& end, double radius)
-        : tag(tag), segments(segments), start(start), end(end), radius(radius) {}
-};
-
-struct NECLoad {
-    int type;        // 0=series RLC, 1=parallel RLC, 4=impedance, 5=conductivity
-    int wireTag;
-    int segStart;
-    int segEnd;
-    double R, L, C;  // Resistance, Inductance, Capacitance
-    
-    NECLoad(int type, int wireTag, int segStart, int segEnd, double R, double L, double C)
-        : type(type), wireTag(wireTag), segStart(segStart), segEnd(segEnd), R(R), L(L), C(C) {}
-};
-
 class NECGenerator {
 public:
     NECGenerator();
@@ -47,6 +30,18 @@ public:
         const WaterProperties* water = nullptr
     );
     
+    // Generate NEC file from a remeshed wire grid
+    std::string generateNEC(
+        const WireGraph& structure,
+        const MaterialProperties& material,
+        const FrequencyCalculator& frequency,
+        const AntennaWire& antenna,
+        const std::string& modelName = "STL Model",
+        bool hasAntenna = true,
+        double waterlineHeight = 0.0,
+        const WaterProperties* water = nullptr
+    );
+    
     // Generate NEC file without antenna
     std::string generateNECStructureOnly(
         const std::vector<Triangle>& triangles,
@@ -54,75 +49,73 @@ public:
         const std::string& modelName = "STL Model"
     );
     
-    // Set output options
-    void setIncludeComments(bool include) { includeComments_ = include; }
-    void setIncludePattern(bool include) { includePattern_ = include; }
-    void setIncludeCurrent(bool include) { includeCurrent_ = include; }
-    
-    // Get generated NEC content
-    const std::string& getNECContent() const { return necContent_; }
-
-private:
-    std::string necContent_;
-    bool includeComments_;
-    bool includePattern_;
-    bool includeCurrent_;
-    
-    // Generate file header
-    std::string generateHeader(const std::string& modelName, const FrequencyCalculator& frequency);
-    
-    // Generate geometry section
-    std::string generateGeometry(
-        const std::vector<Triangle>& triangles,
+    std::string generateNECStructureOnly(
+        const WireGraph& structure,
         const MaterialProperties& material,
-        const AntennaWire& antenna,
-        bool hasAntenna
+        const std::string& modelName = "STL Model"
     );
     
-    // Generate wire definitions
-    std::string generateWires(
-        const std::vector<Triangle>& triangles,
+    // Generate NEC file from a prepared model
+    std::string generateNEC(const WireModel& model);
+    
+    // Stream the deck card by card into an open writer instead of building
+    // it as a string; the writer's buffer is first sized from the card count
+    void writeNEC(DeckWriter& out, const WireModel& model);
+    
+    void writeNEC(
+        DeckWriter& out,
+        const WireGraph& structure,
         const MaterialProperties& material,
+        const FrequencyCalculator& frequency,
         const AntennaWire& antenna,
-        bool hasAntenna
+        const std::string& modelName = "STL Model",
+        bool hasAntenna = true,
+        double waterlineHeight = 0.0,
+        const WaterProperties* water = nullptr
     );
     
-    // Generate antenna wire
-    std::string generateAntennaWire(const AntennaWire& antenna, int& wireTag);
-    
-    // Generate structure wires
-    std::string generateStructureWires(
-        const std::vector<Triangle>& triangles,
+    void writeNECStructureOnly(
+        DeckWriter& out,
+        const WireGraph& structure,
         const MaterialProperties& material,
-        int& wireTag
+        const std::string& modelName = "STL Model"
     );
     
-    // Generate excitation
-    std::string generateExcitation(const AntennaWire& antenna);
-    
-    // Generate ground
-    std::string generateGround(double waterlineHeight, const WaterProperties* water);
-    
-    // Generate frequency
-    std::string generateFrequency(const FrequencyCalculator& frequency);
+    // Closed bodies written as triangular surface patches (SP/SC) after the
+    // wire grid, one per triangle, wound outward; empty = wires only. Used by
+    // the methods that build their own model from a wire graph.
+    void setSurfacePatches(const IndexedMesh& patches) { patches_ = patches; }
+    const IndexedMesh& getSurfacePatches() const { return patches_; }
     
-    // Generate pattern
-    std::string generatePattern();
-    
-    // Generate current
-    std::string generateCurrent();
+    // Set output options
+    void setIncludeComments(bool include) { serializer_.setIncludeComments(include); }
+    void setIncludePattern(bool include) { serializer_.setIncludePattern(include); }
+    void setIncludeCurrent(bool include) { serializer_.setIncludeCurrent(include); }
     
-    // Generate loads
-    std::string generateLoads(const std::vector<NECLoad>& loads);
+    // Get generated NEC content
+    const std::string& getNECContent() const { return necContent_; }
+
+private:
+    std::string necContent_;
+    IndexedMesh patches_;
+    DeckSerializer serializer_;   // Patches as SP/SC cards
     
-    // Helper functions
-    std::vector<NECWire> triangulateToWires(const std::vector<Triangle>& triangles, const MaterialProperties& material);
-    int calculateSegments(double length, double gridSpacing);
-    std::string formatCoordinate(double value);
-    std::string formatScientific(double value);
-    std::string getMaterialComment(const MaterialProperties& material);
+    // Model of a wire graph with the patches set on this generator
+    WireModel buildModel(
+        const WireGraph& structure,
+        const MaterialProperties& material,
+        const FrequencyCalculator& frequency,
+        const AntennaWire& antenna,
+        const std::string& modelName,
+        bool hasAntenna,
+        double waterlineHeight,
+        const WaterProperties* water
+    ) const;
+    WireModel buildStructureOnlyModel(
+        const WireGraph& structure,
+        const MaterialProperties& material,
+        const std::string& modelName
+    ) const;
 };
 
 } // namespace stl_to_eznec
-
-
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include "geometry_utils.h"
+#include "mesh_topology.h"
+
+namespace stl_to_eznec {
+
+// Edge-connected facets lying in one plane, as a single polygon with holes
+struct PlanarRegion {
+    std::vector<uint32_t> faces;
+    std::vector<std::array<uint32_t, 2>> boundary;  // Edges with one region facet, in that facet's winding
+    Point3D origin;     // Area-weighted centroid
+    Point3D normal;
+    Point3D uAxis;      // In-plane, along the dominant boundary direction
+    Point3D vAxis;      // normal x uAxis
+    double area;
+
+    PlanarRegion() : area(0) {}
+};
+
+// Region-growing pass that merges adjacent coplanar facets (decks, bulkheads,
+// roofs) into planar polygons, so they can be gridded directly instead of
+// through their arbitrary triangulation. A region grows from its largest
+// facet across manifold edges to neighbours whose normal is within the angle
+// tolerance of the seed and whose vertices lie within the plane tolerance.
+// Regions are grown in one pass; their boundaries and axes in parallel.
+class PlanarRegionMerger {
+public:
+    explicit PlanarRegionMerger(double angleToleranceDegrees = 1.0);
+
+    // Facets only join regions of the same group (e.g. grading level) when groups are given
+    std::vector<PlanarRegion> merge(const IndexedMesh& mesh, const std::vector<int32_t>& faceGroup = {}) const;
+
+    void setAngleTolerance(double degrees) { angleTolerance_ = degrees; }
+    double getAngleTolerance() const { return angleTolerance_; }
+
+    // Largest vertex distance from the seed plane, in meters
+    void setPlaneTolerance(double distance) { planeTolerance_ = distance; }
+    double getPlaneTolerance() const { return planeTolerance_; }
+
+    // Smaller regions are not returned
+    void setMinArea(double area) { minArea_ = area; }
+    double getMinArea() const { return minArea_; }
+
+private:
+    double angleTolerance_;
+    double planeTolerance_;
+    double minArea_;
+};
+
+} // namespace stl_to_eznec
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <vector>
+#include "geometry_utils.h"
+#include "mesh_topology.h"
+#include "frequency_calculator.h"
+#include "spacing_field.h"
+
+namespace stl_to_eznec {
+
+// Size and edge-length statistics of a structure mesh
+struct MeshStatistics {
+    size_t faceCount;
+    size_t edgeCount;          // Distinct edges
+    double surfaceArea;        // m^2
+    double totalEdgeLength;    // m
+    double meanEdgeLength;
+    double minEdgeLength;
+    double maxEdgeLength;
+    double wireLength;         // Wires added beside the surface grid (collapsed tubes), m
+
+    MeshStatistics() : faceCount(0), edgeCount(0), surfaceArea(0), totalEdgeLength(0),
+                       meanEdgeLength(0), minEdgeLength(0), maxEdgeLength(0), wireLength(0) {}
+};
+
+// Grid spacing and decimation chosen to fit a deck within the solver budget
+struct SegmentPlan {
+    double gridSpacing;             // Structure wire-grid pitch in meters (nearest the antenna when graded)
+    double farSpacing;              // Graded pitch far from the antenna; equals gridSpacing when uniform
+    double decimationEdgeLength;    // Collapse edges shorter than this; 0 = no decimation
+    size_t structureSegments;       // Predicted
+    size_t antennaSegments;
+    size_t totalSegments;
+    size_t deckSegments;            // Counted in the generated deck; 0 until checked
+    double matrixBytes;             // N^2 * 16 (complex double interaction matrix)
+    double factorSeconds;           // N^3 / factor rate
+    bool coarsened;                 // Spacing widened beyond the requested accuracy
+    bool fitsBudget;
+
+    SegmentPlan() : gridSpacing(0), farSpacing(0), decimationEdgeLength(0), structureSegments(0), antennaSegments(0),
+                    totalSegments(0), deckSegments(0), matrixBytes(0), factorSeconds(0), coarsened(false),
+                    fitsBudget(true) {}
+};
+
+// Predicts the segment count of the remeshed structure before anything is
+// generated and widens the grid spacing until the deck fits both the
+// solver's segment limit and the solve-time target. The prediction is only
+// an estimate of the clustering remesher, so the generated deck is counted
+// afterwards and the grid rebuilt wider while it is over the budget.
+class SegmentPlanner {
+public:
+    SegmentPlanner();
+
+    void setMaxSegments(size_t count) { maxSegments_ = count; }
+    size_t getMaxSegments() const { return maxSegments_; }
+
+    // Target time for the O(N^3) matrix factorization, in seconds
+    void setTargetSolveSeconds(double seconds) { targetSolveSeconds_ = seconds; }
+    double getTargetSolveSeconds() const { return targetSolveSeconds_; }
+
+    // N^3 operations per second the solver machine sustains
+    void setFactorRate(double operationsPerSecond) { factorRate_ = operationsPerSecond; }
+    double getFactorRate() const { return factorRate_; }
+
+    static MeshStatistics measure(const IndexedMesh& mesh);
+
+    // Wires of a quasi-uniform triangular grid of pitch h: 2*sqrt(3)*A / h^2,
+    // plus one segment per pitch along the separate wires
+    size_t predictStructureSegments(const MeshStatistics& statistics, double gridSpacing) const;
+
+    // Graded grid: 2*sqrt(3)*A / h^2 summed per facet at the local pitch
+    size_t predictStructureSegments(const IndexedMesh& mesh, const MeshStatistics& statistics,
+                                    const SpacingField& spacing) const;
+
+    // Start from lambda/10 (or lambda/20) and coarsen until the budget is met
+    SegmentPlan plan(const MeshStatistics& statistics, const FrequencyCalculator& frequency,
+                     size_t antennaSegments = 0, bool highAccuracy = false) const;
+
+    // Same for a graded field, which is widened as a whole if the budget is exceeded
+    SegmentPlan plan(const IndexedMesh& mesh, const MeshStatistics& statistics, SpacingField& spacing,
+                     size_t antennaSegments = 0) const;
+
+    // Take the generated deck's segment count (GX and GM copies included)
+    // and its memory and time into the plan; false when over the budget
+    bool checkDeck(SegmentPlan& plan, size_t deckSegments) const;
+
+    // Widen the spacing by the square root of the checked deck's overshoot,
+    // with a small margin, for a rebuild; false when only the antenna could
+    // be cut
+    bool widen(SegmentPlan& plan, SpacingField& spacing) const;
+
+    // Segments of a driven wire path: each piece at the given spacing, odd for a centre feed
+    static size_t countPathSegments(const std::vector<Point3D>& path, double spacing = 0.05);
+
+    static double matrixBytes(size_t segments);
+    double factorSeconds(size_t segments) const;
+
+    void printPlan(const SegmentPlan& plan, const FrequencyCalculator& frequency) const;
+    void printDeckCheck(const SegmentPlan& plan) const;
+
+private:
+    // The tighter of the segment limit and the N^3 time target
+    double segmentBudget() const;
+
+    size_t maxSegments_;
+    double targetSolveSeconds_;
+    double factorRate_;
+};
+
+} // namespace stl_to_eznec
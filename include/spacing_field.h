@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include "geometry_utils.h"
+#include "mesh_topology.h"
+#include "frequency_calculator.h"
+
+namespace stl_to_eznec {
+
+class MeshBVH;
+
+// Target wire-grid pitch at any point of the structure. Uniform by default;
+// graded fields grow linearly with the distance to a set of source facets
+// (the antennas), from the near spacing at the sources to the far spacing
+// at the grading distance and beyond. Distances come from BVH queries, so
+// lookups are read-only and safe from many threads. Copies share the tree.
+class SpacingField {
+public:
+    explicit SpacingField(double spacing = 0.1);
+
+    SpacingField(const IndexedMesh& sources, double nearSpacing, double farSpacing, double gradingDistance);
+
+    // lambda/20 at the antennas, growing to lambda/5 one wavelength away
+    static SpacingField fromFrequency(const FrequencyCalculator& frequency, const IndexedMesh& antennas);
+
+    double spacingAt(const Point3D& point) const;
+
+    // Segments for a straight wire, one per local pitch along it
+    int segmentCount(const Point3D& start, const Point3D& end) const;
+
+    // Widen the pitch everywhere by a factor; the grading distance stays
+    void scale(double factor);
+
+    bool isGraded() const { return bvh_ != nullptr; }
+    double getNearSpacing() const { return nearSpacing_; }
+    double getFarSpacing() const { return farSpacing_; }
+    double getGradingDistance() const { return gradingDistance_; }
+
+private:
+    std::shared_ptr<const IndexedMesh> sources_;
+    std::shared_ptr<const MeshBVH> bvh_;
+    double nearSpacing_;
+    double farSpacing_;
+    double gradingDistance_;
+};
+
+} // namespace stl_to_eznec
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include "geometry_utils.h"
+#include "mesh_topology.h"
+#include "spacing_field.h"
+#include "frequency_calculator.h"
+
+namespace stl_to_eznec {
+
+// How the closed bodies of a structure were modelled
+struct PatchReport {
+    size_t components;
+    size_t closedComponents;     // Watertight and consistently wound
+    size_t attachedComponents;   // Closed, but a wire ends on them
+    size_t patchedComponents;    // Written as surface patches
+    size_t patches;
+    size_t replacedSegments;     // Predicted wire-grid segments of the patched bodies
+
+    PatchReport() : components(0), closedComponents(0), attachedComponents(0), patchedComponents(0), patches(0),
+                    replacedSegments(0) {}
+};
+
+// A structure divided between the wire grid and surface patches
+struct PatchSplit {
+    IndexedMesh wireMesh;      // Components left for the wire grid
+    IndexedMesh patchedMesh;   // Facets of the patched components, wound outward
+    IndexedMesh patches;       // One NEC patch per triangle, wound outward
+};
+
+// Chooses, per connected component, between a wire grid and NEC surface
+// patches (SP/SM). Only closed bodies qualify: every edge is shared by two
+// facets in opposite directions, or lies on the mirror plane. Bodies a wire
+// (tube or antenna) ends on stay wire grids, since NEC joins wires to
+// patches only at patch centres. A body is patched when its patches, two
+// unknowns each, take fewer unknowns than its predicted wire segments.
+class SurfacePatcher {
+public:
+    explicit SurfacePatcher(double patchSize = 0.2);
+
+    // Cells of lambda/5, keeping patches near the usual 0.04 lambda^2 limit,
+    // and never finer than the wire grid
+    static SurfacePatcher fromFrequency(const FrequencyCalculator& frequency, double gridSpacing);
+
+    // Attachments are wire points; a body within attachDistance of one keeps its wires
+    PatchSplit split(const IndexedMesh& mesh, const SpacingField& wireSpacing, const std::vector<Point3D>& attachments,
+                     double attachDistance, PatchReport* report = nullptr) const;
+
+    void setPatchSize(double size) { patchSize_ = size; }
+    double getPatchSize() const { return patchSize_; }
+
+    // Coordinate plane through the origin (0 = x, 1 = y) of a GX reflection;
+    // -1 = none. Open edges on it count as closed.
+    void setMirrorPlane(int axis) { mirrorAxis_ = axis; }
+    int getMirrorPlane() const { return mirrorAxis_; }
+
+    static void printReport(const PatchReport& report);
+
+private:
+    double patchSize_;
+    int mirrorAxis_;
+};
+
+} // namespace stl_to_eznec
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <vector>
+#include "geometry_utils.h"
+#include "mesh_topology.h"
+#include "wire_graph.h"
+#include "frequency_calculator.h"
+#include "spacing_field.h"
+
+namespace stl_to_eznec {
+
+// Resamples a triangle surface into a quasi-uniform wire grid.
+// Long edges are bisected until no edge exceeds the target length, then
+// vertices are clustered on a grid of the same pitch. Vertices on sharp or
+// open edges win their cell, so creases and outlines survive the clustering.
+// Coplanar facets are merged into planar panels whose interior is gridded
+// with a square lattice of the same pitch clipped to the panel outline,
+// instead of following the arbitrary triangulation of the panel.
+// With a graded spacing field the target length varies over the surface and
+// each vertex is clustered on the grid whose power-of-two multiple of the
+// near spacing matches its local pitch. The pitch never exceeds half the
+// largest extent of the body a vertex belongs to, so a body smaller than
+// two cells is gridded finer instead of collapsing into one node.
+class SurfaceRemesher {
+public:
+    explicit SurfaceRemesher(double targetEdgeLength = 0.1);
+
+    // Edge length from the operating wavelength: lambda/10, or lambda/20
+    static SurfaceRemesher fromFrequency(const FrequencyCalculator& frequency, bool highAccuracy = false);
+
+    // Build the welded wire grid for a surface
+    WireGraph remesh(const std::vector<Triangle>& triangles) const;
+    WireGraph remesh(const IndexedMesh& mesh) const;
+
+    // Same, with the pitch taken from the field instead of the target edge length
+    WireGraph remesh(const IndexedMesh& mesh, const SpacingField& spacing) const;
+
+    // Triangles between the cell nodes instead of wires, in the input winding,
+    // for surface patch output; facets lying in the mirror plane are dropped
+    IndexedMesh remeshTriangles(const IndexedMesh& mesh, const SpacingField& spacing) const;
+
+    void setTargetEdgeLength(double length) { targetEdgeLength_ = length; }
+    double getTargetEdgeLength() const { return targetEdgeLength_; }
+
+    // Dihedral angle in degrees above which an edge is kept as a feature
+    void setFeatureAngle(double degrees) { featureAngle_ = degrees; }
+    double getFeatureAngle() const { return featureAngle_; }
+
+    // Normal tolerance in degrees for merging coplanar facets into panels; 0 = off
+    void setPanelAngle(double degrees) { panelAngle_ = degrees; }
+    double getPanelAngle() const { return panelAngle_; }
+
+    // Coordinate plane through the origin (0 = x, 1 = y, 2 = z) the input was
+    // clipped at; -1 = none. Cut vertices on that plane win their cell so the
+    // seam nodes stay exactly on it, and wires lying in the plane are dropped
+    // because the reflected half would duplicate them.
+    void setMirrorPlane(int axis) { mirrorAxis_ = axis; }
+    int getMirrorPlane() const { return mirrorAxis_; }
+
+    // The input was clipped at a ground plane z = 0 (a hull at the
+    // waterline). It is a seam like the mirror plane: nodes on it stay
+    // there and wires in it, which would coincide with their image, are dropped.
+    void setGroundPlane(bool enabled) { groundPlane_ = enabled; }
+    bool getGroundPlane() const { return groundPlane_; }
+
+    // Split the longest edge of every face until all edges are <= maxLength
+    static IndexedMesh refine(const IndexedMesh& mesh, double maxLength);
+
+    // Split edges longer than the field's pitch at either end
+    static IndexedMesh refine(const IndexedMesh& mesh, const SpacingField& spacing);
+
+    // Per-vertex count of incident feature (sharp, open or non-manifold) edges
+    static std::vector<uint32_t> featureDegrees(const IndexedMesh& mesh, double featureAngleDegrees);
+
+    // Largest pitch at every vertex that leaves its body two cells across:
+    // half the largest bounding-box extent of its connected component
+    static std::vector<double> bodyPitchLimits(const IndexedMesh& mesh);
+
+private:
+    // Vertices of a refined mesh grouped into grid cells, one node per cell
+    struct Clustering {
+        std::vector<uint32_t> cluster;      // Node of every vertex
+        std::vector<Point3D> points;        // Position of every node
+        std::vector<uint8_t> onMirror;      // Node lies on the mirror seam or the ground plane
+        std::vector<int32_t> vertexLevel;   // Grid level of every vertex; empty when uniform
+    };
+
+    Clustering clusterVertices(const IndexedMesh& mesh, const SpacingField& spacing,
+                               const std::vector<double>& limits) const;
+
+    // Refinement with the pitch capped per vertex; limits is extended for
+    // the vertices added
+    static IndexedMesh refine(const IndexedMesh& mesh, const SpacingField& spacing, std::vector<double>& limits);
+
+    // Within a thousandth of the pitch of the plane, so vertices left a
+    // rounding error off it do not become nodes of their own beside it
+    bool isOnSeam(const Point3D& p) const {
+        double tolerance = 1e-3 * targetEdgeLength_;
+        return (mirrorAxis_ >= 0 && std::abs(mirrorAxis_ == 0 ? p.x : (mirrorAxis_ == 1 ? p.y : p.z)) <= tolerance) ||
+               (groundPlane_ && std::abs(p.z) <= tolerance);
+    }
+
+    double targetEdgeLength_;
+    double featureAngle_;
+    double panelAngle_;
+    int mirrorAxis_;
+    bool groundPlane_;
+};
+
+} // namespace stl_to_eznec
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include "geometry_utils.h"
+#include "mesh_topology.h"
+
+namespace stl_to_eznec {
+
+// Mirror plane found in a structure; axis -1 = none
+struct SymmetryPlane {
+    int axis;                      // 0 = x = 0 plane, 1 = y = 0 plane
+    double matchFraction;          // Vertices whose mirror image is also a vertex
+    double inPlaneAreaFraction;    // Surface lying in the plane itself
+
+    SymmetryPlane() : axis(-1), matchFraction(0), inPlaneAreaFraction(0) {}
+
+    bool found() const { return axis >= 0; }
+};
+
+// Finds a mirror plane that NEC's GX card can reproduce. GX reflects across
+// coordinate planes through the origin, so only the x = 0 and y = 0 planes
+// are candidates (z = 0 is the ground side of a vehicle). Each vertex is
+// mirrored and looked up in a spatial hash; the plane is accepted when
+// nearly every vertex has a partner and almost no surface lies in the plane,
+// since wires in the plane cannot be reflected.
+class SymmetryDetector {
+public:
+    SymmetryDetector();
+
+    // Match tolerance as a fraction of the bounding-box diagonal
+    void setTolerance(double relativeTolerance) { tolerance_ = relativeTolerance; }
+    double getTolerance() const { return tolerance_; }
+
+    // Share of vertices that must have a mirror partner
+    void setMinMatchFraction(double fraction) { minMatchFraction_ = fraction; }
+    double getMinMatchFraction() const { return minMatchFraction_; }
+
+    // Share of the surface area allowed to lie in the plane
+    void setMaxInPlaneFraction(double fraction) { maxInPlaneFraction_ = fraction; }
+    double getMaxInPlaneFraction() const { return maxInPlaneFraction_; }
+
+    // Best accepted candidate plane
+    SymmetryPlane detect(const IndexedMesh& mesh) const;
+
+    // Evaluate one origin plane without applying the thresholds
+    SymmetryPlane evaluate(const IndexedMesh& mesh, int axis) const;
+
+    // The half on the positive side of the plane, split along it
+    static IndexedMesh keepHalf(const IndexedMesh& mesh, const SymmetryPlane& plane);
+
+    // How far the positive half reaches from the plane
+    static double halfExtent(const IndexedMesh& mesh, const SymmetryPlane& plane);
+
+private:
+    double tolerance_;
+    double minMatchFraction_;
+    double maxInPlaneFraction_;
+};
+
+} // namespace stl_to_eznec
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include "geometry_utils.h"
+#include "mesh_topology.h"
+#include "frequency_calculator.h"
+
+namespace stl_to_eznec {
+
+// Plates found modelled as two skins and merged
+struct ThinShellReport {
+    size_t inputFacets;
+    size_t pairedFacets;      // Facets with an opposing skin within the thickness limit
+    size_t skins;             // Edge-connected sheets of paired facets
+    size_t collapsedSkins;    // Sheets moved onto the mid-surface
+    size_t thickSkins;        // Pairs kept because they are thick for their width
+    size_t removedFacets;     // Opposing skins and the rims joining them
+    double meanThickness;     // Over the collapsed facets
+    size_t outputFacets;
+
+    ThinShellReport() : inputFacets(0), pairedFacets(0), skins(0), collapsedSkins(0), thickSkins(0),
+                        removedFacets(0),
+                        meanThickness(0), outputFacets(0) {}
+};
+
+// Detects plates modelled as thin solids (an inner and an outer skin a few
+// millimetres apart) and replaces each pair of skins with one mid-surface.
+// Every facet casts a ray into the solid through a BVH; a facet with an
+// opposing normal closer than the thickness limit is its partner. Paired
+// facets are grouped into sheets across smooth edges, the larger sheet of
+// each pair is moved half the thickness inward and the other is dropped
+// together with the rim facets between them. A pair is only merged when its
+// thickness is small against the sheets' width, so the opposite walls of a
+// box-section tube are left alone whatever the thickness limit.
+class ThinShellCollapser {
+public:
+    explicit ThinShellCollapser(double maxThickness = 0.01);
+
+    // Skins closer than lambda / divisions are merged
+    static ThinShellCollapser fromFrequency(const FrequencyCalculator& frequency, double divisions = 50.0);
+
+    IndexedMesh collapse(const IndexedMesh& mesh, ThinShellReport* report = nullptr) const;
+
+    // Largest wall thickness treated as a double skin, in meters
+    void setMaxThickness(double thickness) { maxThickness_ = thickness; }
+    double getMaxThickness() const { return maxThickness_; }
+
+    // Largest thickness of a merged pair as a fraction of the narrower sheet's width
+    void setMaxThicknessToWidth(double ratio) { maxThicknessToWidth_ = ratio; }
+    double getMaxThicknessToWidth() const { return maxThicknessToWidth_; }
+
+    // Partner normals must be within acos(cosine) of exactly opposite
+    void setOpposingCosine(double cosine) { opposingCosine_ = cosine; }
+    double getOpposingCosine() const { return opposingCosine_; }
+
+    static void printReport(const ThinShellReport& report);
+
+private:
+    double maxThickness_;
+    double maxThicknessToWidth_;
+    double opposingCosine_;
+};
+
+} // namespace stl_to_eznec
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+namespace stl_to_eznec {
+
+class ThreadPool {
+public:
+    // threadCount = 0 uses the hardware concurrency
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned getThreadCount() const { return static_cast<unsigned>(workers_.size()); }
+
+    // Queue a task and get a future for its result
+    template<typename F>
+    auto submit(F task) -> std::future<typename std::invoke_result<F>::type>;
+
+    // Run body(begin, end) over [0, count) in contiguous chunks and wait for all.
+    // Must not be called from inside a pool task.
+    void parallelFor(size_t count, const std::function<void(size_t, size_t)>& body, size_t minChunk = 1);
+
+    // Shared pool sized to the machine
+    static ThreadPool& getInstance();
+
+private:
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stopping_;
+
+    void workerLoop();
+};
+
+template<typename F>
+auto ThreadPool::submit(F task) -> std::future<typename std::invoke_result<F>::type> {
+    using Result = typename std::invoke_result<F>::type;
+
+    auto packaged = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+    std::future<Result> future = packaged->get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.emplace([packaged]() { (*packaged)(); });
+    }
+    condition_.notify_one();
+
+    return future;
+}
+
+} // namespace stl_to_eznec
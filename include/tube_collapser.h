@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include "geometry_utils.h"
+#include "mesh_topology.h"
+#include "wire_graph.h"
+#include "frequency_calculator.h"
+
+namespace stl_to_eznec {
+
+// Tubular components found and replaced by wires
+struct TubeReport {
+    size_t inputFacets;
+    size_t tubes;             // Components replaced by a centerline wire
+    size_t tubeFacets;        // Facets those components had
+    size_t inPlaneTubes;      // Lying in the mirror plane; left as facets
+    size_t wires;             // Straight wires on the centerlines
+    double totalLength;       // Of those wires, in meters
+    size_t outputFacets;
+
+    TubeReport() : inputFacets(0), tubes(0), tubeFacets(0), inPlaneTubes(0), wires(0), totalLength(0),
+                   outputFacets(0) {}
+};
+
+// Facets left after the tubes were taken out, and their wires
+struct TubeSet {
+    IndexedMesh remainder;
+    WireGraph wires;          // Per-edge radius of each tube; nodes not yet joined to the grid
+};
+
+// Replaces structural tubes (masts, rails, stays, supports) with a single
+// centerline wire of equivalent radius instead of a wire grid around the
+// circumference. Components are classified in parallel with the antenna
+// detector's wire test, widened to the tube diameter limit, then kept only
+// if slender and if every vertex lies within two radii of the centerline.
+class TubeCollapser {
+public:
+    explicit TubeCollapser(double maxDiameter = 0.035);
+
+    // Tubes thinner than lambda / divisions become wires
+    static TubeCollapser fromFrequency(const FrequencyCalculator& frequency, double divisions = 20.0);
+
+    TubeSet collapse(const IndexedMesh& mesh, TubeReport* report = nullptr) const;
+
+    void setMaxDiameter(double diameter) { maxDiameter_ = diameter; }
+    double getMaxDiameter() const { return maxDiameter_; }
+
+    // Shortest tube, as a multiple of its diameter
+    void setMinSlenderness(double ratio) { minSlenderness_ = ratio; }
+    double getMinSlenderness() const { return minSlenderness_; }
+
+    // Origin plane (0 = x, 1 = y) of a GX reflection; -1 = none. Wires crossing
+    // it are cut there, tubes lying in it stay facets and tubes wholly on the
+    // negative side are left for the half-model clip.
+    void setMirrorPlane(int axis) { mirrorAxis_ = axis; }
+    int getMirrorPlane() const { return mirrorAxis_; }
+
+    static void printReport(const TubeReport& report);
+
+private:
+    double maxDiameter_;
+    double minSlenderness_;
+    int mirrorAxis_;
+};
+
+} // namespace stl_to_eznec
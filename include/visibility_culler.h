@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include "geometry_utils.h"
+#include "mesh_topology.h"
+#include "frequency_calculator.h"
+
+namespace stl_to_eznec {
+
+// Facets kept and removed by a visibility pass
+struct VisibilityReport {
+    size_t inputFacets;
+    size_t sphereHits;        // Facets hit first by rays from the enclosing sphere
+    size_t escapeHits;        // Further facets with an unobstructed ray to the outside
+    size_t hiddenFacets;      // Removed
+    size_t raysCast;
+
+    VisibilityReport() : inputFacets(0), sphereHits(0), escapeHits(0), hiddenFacets(0), raysCast(0) {}
+};
+
+// Removes interior geometry (engine rooms, bulkheads, furniture) that the
+// hull shields from any external field. Parallel rays are cast inward from
+// the enclosing sphere over a set of directions, and the first facet each
+// ray hits is exterior. Small facets the sample grid misses get a second
+// test: rays from the facet outward, kept if any escapes the sphere. Both
+// passes query one BVH from all pool threads. The ray spacing need not be
+// finer than the wire grid pitch: the escape test covers what it misses.
+class VisibilityCuller {
+public:
+    explicit VisibilityCuller(double sampleSpacing = 0.05);
+
+    // Ray spacing lambda / divisions, by default the finest grid pitch
+    static VisibilityCuller fromFrequency(const FrequencyCalculator& frequency, double divisions = 20.0);
+
+    IndexedMesh cull(const IndexedMesh& mesh, VisibilityReport* report = nullptr) const;
+
+    // Spacing of the parallel ray grid in meters
+    void setSampleSpacing(double spacing) { sampleSpacing_ = spacing; }
+    double getSampleSpacing() const { return sampleSpacing_; }
+
+    // Directions on the sphere, for both the inward and the escape rays
+    void setDirectionCount(unsigned count) { directionCount_ = count; }
+    unsigned getDirectionCount() const { return directionCount_; }
+
+    static void printReport(const VisibilityReport& report);
+
+private:
+    double sampleSpacing_;
+    unsigned directionCount_;
+};
+
+} // namespace stl_to_eznec
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include "geometry_utils.h"
+#include "mesh_topology.h"
+
+namespace stl_to_eznec {
+
+// Result of a waterline clip
+struct WaterlineReport {
+    double gunwaleZ;          // Estimated top of the hull sides
+    double waterlineZ;        // Clip height in model coordinates
+    size_t inputFacets;
+    size_t submergedFacets;   // Removed entirely
+    size_t splitFacets;       // Crossing the waterline
+    size_t outputFacets;
+
+    WaterlineReport() : gunwaleZ(0), waterlineZ(0), inputFacets(0), submergedFacets(0), splitFacets(0),
+                        outputFacets(0) {}
+};
+
+// Cuts a hull at the waterline for a water ground plane. The waterline sits
+// the entered freeboard (waterline-to-gunwale distance) below the gunwale,
+// estimated as the highest level where the model still spans most of its
+// length. Facets are split in one parallel pass, everything below is
+// dropped, and the result is lowered so the waterline lies on the NEC
+// ground plane at z = 0. The contour is left open: the ground card stands
+// in for the submerged hull, and wires in the plane would coincide with
+// their image. Only for decks that write a ground card.
+class WaterlineClipper {
+public:
+    explicit WaterlineClipper(double freeboard);
+
+    IndexedMesh clip(const IndexedMesh& mesh, WaterlineReport* report = nullptr) const;
+
+    // Highest z where facets still span this share of the hull length
+    void setHullSpanFraction(double fraction) { hullSpanFraction_ = fraction; }
+    double getHullSpanFraction() const { return hullSpanFraction_; }
+
+    double getFreeboard() const { return freeboard_; }
+
+    static double estimateGunwaleHeight(const IndexedMesh& mesh, double hullSpanFraction = 0.9);
+
+    static void printReport(const WaterlineReport& report);
+
+private:
+    double freeboard_;
+    double hullSpanFraction_;
+};
+
+} // namespace stl_to_eznec
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include "geometry_utils.h"
+
+namespace stl_to_eznec {
+
+// Copies of a prototype edge range made by one GM card. Copy k is the
+// prototype stepped k times: rotated about the z axis, then translated.
+struct WireReplication {
+    size_t edgeBegin;           // Prototype edges [edgeBegin, edgeEnd)
+    size_t edgeEnd;
+    int copies;                 // Copies beyond the prototype
+    double rotateZDegrees;      // Per-step rotation about the z axis
+    Point3D translation;        // Per-step translation after the rotation
+
+    WireReplication() : edgeBegin(0), edgeEnd(0), copies(0), rotateZDegrees(0) {}
+};
+
+// Welded wire grid: shared nodes joined by straight wires. Every edge is
+// stored once as (lower node id, higher node id).
+struct WireGraph {
+    std::vector<Point3D> nodes;
+    std::vector<std::array<uint32_t, 2>> edges;
+    std::vector<int> edgeSegments;   // Per-edge segment count; empty = from segmentLength
+    std::vector<double> edgeRadii;   // Per-edge wire radius; empty = wireRadius for all
+    double segmentLength;            // Target segment length in meters
+    double wireRadius;               // Radius of grid wires in meters
+    int mirrorAxis;                  // Origin plane (0 = x, 1 = y, 2 = z) the wires are reflected across; -1 = none
+    std::vector<WireReplication> replications;  // Ranges after the base edges, in edge order
+
+    WireGraph() : segmentLength(0.1), wireRadius(0.002), mirrorAxis(-1) {}
+
+    size_t nodeCount() const { return nodes.size(); }
+    size_t edgeCount() const { return edges.size(); }
+    bool empty() const { return edges.empty(); }
+
+    const Point3D& edgeStart(size_t edge) const { return nodes[edges[edge][0]]; }
+    const Point3D& edgeEnd(size_t edge) const { return nodes[edges[edge][1]]; }
+    double edgeLength(size_t edge) const { return edgeStart(edge).distance(edgeEnd(edge)); }
+
+    int segmentCount(size_t edge) const {
+        if (!edgeSegments.empty()) return edgeSegments[edge];
+        if (segmentLength <= 0.0) return 1;
+        // Small slack so an edge of exactly one pitch is not split by rounding
+        return std::max(1, static_cast<int>(std::ceil(edgeLength(edge) / segmentLength - 1e-9)));
+    }
+
+    double radius(size_t edge) const { return edgeRadii.empty() ? wireRadius : edgeRadii[edge]; }
+
+    // Edges written as-is, ahead of the replicated prototypes
+    size_t baseEdgeCount() const { return replications.empty() ? edges.size() : replications.front().edgeBegin; }
+
+    // Edges [begin, end) and the nodes they use, renumbered
+    WireGraph edgeRange(size_t begin, size_t end) const;
+
+    // Add a prototype with its own nodes and record how it is replicated
+    void appendReplicated(const WireGraph& prototype, int copies, double rotateZDegrees, const Point3D& translation);
+
+    // Add wires to the base edges. A wire end within snapDistance of an
+    // existing node is joined to the nearest one.
+    void appendWires(const WireGraph& wires, double snapDistance = 0.0);
+
+    // Join a point to the base edges: the nearest node within snapDistance,
+    // else a new node splitting the nearest wire within it. Returns the
+    // node, or 0xFFFFFFFF when nothing is in reach.
+    uint32_t joinPoint(const Point3D& point, double snapDistance);
+
+    double totalLength() const {
+        double total = 0.0;
+        for (size_t e = 0; e < edges.size(); ++e) {
+            total += edgeLength(e);
+        }
+        return total;
+    }
+
+    // Replace runs of nearly collinear edges of equal radius through degree-2
+    // nodes with one edge carrying the summed segment count. The base edges
+    // and every replicated prototype are merged separately.
+    WireGraph mergeCollinearChains(double angleToleranceDegrees = 2.0) const;
+};
+
+} // namespace stl_to_eznec
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "geometry_utils.h"
+#include "material_database.h"
+#include "frequency_calculator.h"
+#include "antenna_detector.h"
+#include "wire_graph.h"
+#include "mesh_topology.h"
+#include "nec_deck.h"
+
+namespace stl_to_eznec {
+
+struct NECLoad {
+    int type;        // 0=series RLC, 1=parallel RLC, 4=impedance, 5=conductivity
+    int wireTag;
+    int segStart;
+    int segEnd;
+    double R, L, C;  // Resistance, Inductance, Capacitance
+
+    NECLoad(int type, int wireTag, int segStart, int segEnd, double R, double L, double C)
+        : type(type), wireTag(wireTag), segStart(segStart), segEnd(segEnd), R(R), L(L), C(C) {}
+};
+
+// Voltage source on one segment (EX 0)
+struct NECExcitation {
+    int wireTag;
+    int segment;
+    double real;
+    double imaginary;
+
+    NECExcitation(int wireTag, int segment, double real = 1.0, double imaginary = 0.0)
+        : wireTag(wireTag), segment(segment), real(real), imaginary(imaginary) {}
+};
+
+// Copies of the wires [wireBegin, wireEnd) made by one GM card, or by a GR
+// card when they are a full turn about the z axis at the start of the deck.
+// The card follows the last prototype wire.
+struct ModelReplication {
+    size_t wireBegin;
+    size_t wireEnd;
+    int copies;                 // Copies beyond the prototype
+    double rotateZDegrees;
+    Point3D translation;
+    bool rotational;            // Written as GR
+
+    ModelReplication() : wireBegin(0), wireEnd(0), copies(0), rotateZDegrees(0), rotational(false) {}
+};
+
+// Format-neutral model of a deck: a columnar wire table,
+// patches, symmetry, sources, loads, ground and frequency. It is built once
+// from the wire grid, and DeckSerializer writes it for both NEC and EZ.
+struct WireModel {
+    std::string modelName;
+    MaterialProperties material;
+    FrequencyCalculator frequency;
+    bool structureOnly;              // No source or control cards
+
+    // Antenna pieces first, then the structure, in tag order
+    NECDeck wires;
+    size_t antennaWires;
+    std::vector<ModelReplication> replications;
+    int tagCount;                    // Tags used by the wires and their copies
+
+    // Surface patches follow every wire. Formats without patches write the
+    // stand-in wire grid instead, tagged after tagCount.
+    IndexedMesh patches;
+    NECDeck patchWires;
+
+    int mirrorAxis;                  // GX plane through the origin (0 = x, 1 = y, 2 = z); -1 = none
+
+    // Pitch the structure was gridded at, nearest and farthest from the
+    // antenna; 0 when the wires are facet edges
+    double gridSpacing;
+    double farGridSpacing;
+
+    std::vector<NECExcitation> excitations;
+    std::vector<NECLoad> loads;
+
+    int groundType;                  // GN type: -1 = perfect, 2 = finite with the values below
+    double groundPermittivity;
+    double groundConductivity;
+
+    WireModel() : structureOnly(false), antennaWires(0), tagCount(0), mirrorAxis(-1), gridSpacing(0), farGridSpacing(0),
+                  groundType(-1), groundPermittivity(1.0), groundConductivity(0.0) {}
+
+    // Complete deck: antenna pieces fed at the segment nearest the feed
+    // point, and a water ground when a waterline is given
+    static WireModel build(
+        const WireGraph& structure,
+        const MaterialProperties& material,
+        const FrequencyCalculator& frequency,
+        const AntennaWire& antenna,
+        const std::string& modelName = "STL Model",
+        bool hasAntenna = true,
+        double waterlineHeight = 0.0,
+        const WaterProperties* water = nullptr
+    );
+
+    static WireModel buildStructureOnly(
+        const WireGraph& structure,
+        const MaterialProperties& material,
+        const std::string& modelName = "STL Model"
+    );
+
+    // Facet edges of an STL model as a wire graph, straight runs joined
+    static WireGraph buildEdgeWires(const std::vector<Triangle>& triangles);
+
+    // Patches, wound outward, and the wire grid standing in for them
+    void setSurfacePatches(const IndexedMesh& patchMesh, const WireGraph& standIn);
+
+    // Cards a deck will take, with patches or with their stand-in wires
+    size_t cardCount(bool withPatches) const;
+
+    // Unknowns the solver sees in the larger of the two decks: wire
+    // segments with their GM/GR copies, plus two per patch or the stand-in
+    // segments, all doubled by a GX reflection
+    size_t solverUnknowns() const;
+};
+
+} // namespace stl_to_eznec
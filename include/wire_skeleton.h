@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+#include "geometry_utils.h"
+#include "mesh_topology.h"
+
+namespace stl_to_eznec {
+
+struct WireCenterline {
+    std::vector<Point3D> path;  // One point per cross-section ring, ordered along the axis
+    Point3D axis;               // Unit principal axis of the component
+    double radius;              // Mean cross-section ring radius in meters
+    int ringCount;
+
+    WireCenterline() : radius(0), ringCount(0) {}
+};
+
+class WireSkeleton {
+public:
+    // Slice a tube component along its principal axis into an ordered centerline
+    static WireCenterline extractCenterline(const std::vector<Triangle>& triangles);
+
+    // Same, reading the vertices of a component view in place
+    static WireCenterline extractCenterline(const ComponentView& component);
+
+    // Same, for an already welded set of unique vertices
+    static WireCenterline extractCenterline(const std::vector<Point3D>& vertices);
+};
+
+} // namespace stl_to_eznec
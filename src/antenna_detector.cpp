@@ -1,4 +1,9 @@
 #include "antenna_detector.h"
+#include "mesh_topology.h"
+#include "wire_skeleton.h"
+#include "covariance_accumulator.h"
+#include "thread_pool.h"
+#include "mesh_bvh.h"
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
@@ -7,7 +12,7 @@
 namespace stl_to_eznec {
 
 AntennaDetector::AntennaDetector() 
-    : maxWireDiameter_(0.01), minWireLength_(0.1), maxWireLength_(10.0) {
+    : maxWireDiameter_(0.01), minWireLength_(0.1), maxWireLength_(10.0), pathTolerance_(1e-3), minWireTriangles_(6) {
 }
 
 AntennaWire AntennaDetector::detectAntenna(const std::vector<Triangle>& triangles) {
@@ -18,103 +23,207 @@ AntennaWire AntennaDetector::detectAntenna(const std::vector<Triangle>& triangle
     }
     
     // Find wire-like components
-    std::vector<std::vector<Triangle>> components = findWireLikeComponents(triangles);
+    std::vector<ComponentView> components = findWireLikeComponents(triangles);
     
     // Look for the most likely antenna candidate
-    for (const auto& component : components) {
-        if (isWireLikeComponent(component)) {
-            std::vector<Point3D> path = extractWirePath(component);
-            double length = calculateWireLength(path);
-            double radius = calculateWireRadius(component);
-            
-            if (isReasonableAntennaLength(length) && isReasonableAntennaRadius(radius)) {
-                antenna_.triangles = component;
-                antenna_.path = path;
-                antenna_.radius = radius;
-                antenna_.length = length;
-                antenna_.isDetected = true;
-                
-                if (!path.empty()) {
-                    antenna_.startPoint = path.front();
-                    antenna_.endPoint = path.back();
-                }
-                break;
-            }
+    for (size_t c = 0; c < components.size(); ++c) {
+        AntennaWire candidate = evaluateComponent(components[c]);
+        if (candidate.isDetected) {
+            antenna_ = candidate;
+            antenna_.componentId = static_cast<int>(c);
+            break;
         }
     }
     
+    if (antenna_.isDetected) {
+        std::vector<AntennaWire> wires(1, antenna_);
+        placeFeedPoints(wires);
+        antenna_.feedPoint = wires.front().feedPoint;
+    }
+    
     return antenna_;
 }
 
-std::vector<std::vector<Triangle>> AntennaDetector::findWireLikeComponents(const std::vector<Triangle>& triangles) {
-    // For now, return all triangles as separate components
-    // In a more sophisticated implementation, we would group connected triangles
-    std::vector<std::vector<Triangle>> components;
+std::vector<AntennaWire> AntennaDetector::detectAllAntennas(const std::vector<Triangle>& triangles) {
+    antennas_.clear();
+    antenna_ = AntennaWire();
+    
+    if (triangles.empty()) {
+        return antennas_;
+    }
+    
+    antennas_ = detectWires(findWireLikeComponents(triangles));
+    placeFeedPoints(antennas_);
+    
+    // Best score first; component order breaks ties so ranking is deterministic
+    std::stable_sort(antennas_.begin(), antennas_.end(), [](const AntennaWire& a, const AntennaWire& b) {
+        return a.score > b.score;
+    });
     
-    for (const auto& triangle : triangles) {
-        components.push_back({triangle});
+    if (!antennas_.empty()) {
+        antenna_ = antennas_.front();
     }
     
-    return components;
+    return antennas_;
 }
 
-bool AntennaDetector::isWireLikeComponent(const std::vector<Triangle>& component) {
-    if (component.empty()) return false;
+std::vector<AntennaWire> AntennaDetector::detectWires(const std::vector<ComponentView>& components) const {
+    std::vector<AntennaWire> results(components.size());
     
-    BoundingBox bbox = GeometryUtils::calculateBoundingBox(component);
-    Point3D size = bbox.size();
+    // Every component is scored independently; results land in their own slot
+    ThreadPool::getInstance().parallelFor(components.size(), [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            results[c] = evaluateComponent(components[c]);
+            results[c].componentId = static_cast<int>(c);
+        }
+    });
     
-    // Check if it's thin in two dimensions (wire-like)
-    std::vector<double> dimensions = {size.x, size.y, size.z};
-    std::sort(dimensions.begin(), dimensions.end());
+    std::vector<AntennaWire> wires;
+    for (auto& result : results) {
+        if (result.isDetected) {
+            wires.push_back(std::move(result));
+        }
+    }
+    return wires;
+}
+
+bool AntennaDetector::passesQuickRejection(const ComponentView& component) const {
+    // Too few facets to enclose a tube
+    if (component.size() < minWireTriangles_) return false;
     
-    // Wire should be thin in two dimensions
-    return (dimensions[0] <= maxWireDiameter_ && dimensions[1] <= maxWireDiameter_);
+    // Bounding box diagonal bounds the wire length from above and below
+    const IndexedMesh& mesh = component.mesh();
+    BoundingBox bbox(mesh.vertices[mesh.faces[*component.begin()][0]], mesh.vertices[mesh.faces[*component.begin()][0]]);
+    for (uint32_t face : component) {
+        for (uint32_t v : mesh.faces[face]) {
+            bbox.expand(mesh.vertices[v]);
+        }
+    }
+    double diagonal = bbox.diagonal();
+    return diagonal >= minWireLength_ && diagonal <= maxWireLength_ + 2.0 * maxWireDiameter_;
 }
 
-std::vector<Point3D> AntennaDetector::extractWirePath(const std::vector<Triangle>& component) {
-    std::vector<Point3D> path;
+AntennaWire AntennaDetector::evaluateComponent(const ComponentView& component) const {
+    AntennaWire candidate;
     
-    if (component.empty()) return path;
+    // Cheap tests first; oriented-box and skeleton only run on the survivors
+    if (!passesQuickRejection(component)) return candidate;
     
-    // For now, return the centers of triangles as a simple path
-    // In a more sophisticated implementation, we would trace the actual wire path
-    for (const auto& triangle : component) {
-        path.push_back(triangle.center());
+    if (!isWireLikeComponent(component)) return candidate;
+    
+    // One skeleton pass yields both the centerline and the ring radius
+    WireCenterline centerline = WireSkeleton::extractCenterline(component);
+    std::vector<Point3D> path = simplifyPath(centerline.path, pathTolerance_);
+    double length = calculateWireLength(path);
+    double radius = centerline.radius;
+    
+    if (!isReasonableAntennaLength(length) || !isReasonableAntennaRadius(radius) || path.empty()) {
+        return candidate;
     }
     
-    return simplifyPath(path);
+    candidate.component = component;
+    candidate.path = path;
+    candidate.radius = radius;
+    candidate.length = length;
+    candidate.startPoint = path.front();
+    candidate.endPoint = path.back();
+    candidate.feedPoint = chooseFeedPoint(path, false, false);
+    candidate.score = length / radius;  // Slenderness
+    candidate.isDetected = true;
+    
+    return candidate;
 }
 
-double AntennaDetector::calculateWireRadius(const std::vector<Triangle>& component) {
-    if (component.empty()) return 0.0;
+Point3D AntennaDetector::chooseFeedPoint(const std::vector<Point3D>& path, bool startAttached,
+                                         bool endAttached) const {
+    if (path.size() < 2) return path.empty() ? Point3D() : path.front();
     
-    // Calculate average distance from center to vertices
-    Point3D center(0, 0, 0);
-    int vertexCount = 0;
+    // Whips and monopoles are fed where they meet the structure or ground;
+    // the lower end when both ends do
+    if (startAttached && endAttached) {
+        return path.front().z <= path.back().z ? path.front() : path.back();
+    }
+    if (startAttached) return path.front();
+    if (endAttached) return path.back();
     
-    for (const auto& triangle : component) {
-        for (const auto& vertex : triangle.vertices) {
-            center = center + vertex;
-            vertexCount++;
+    // Free at both ends (dipoles and wire antennas): halfway along the path
+    double half = calculateWireLength(path) / 2.0;
+    for (size_t i = 1; i < path.size(); ++i) {
+        double piece = path[i-1].distance(path[i]);
+        if (piece >= half && piece > 0) {
+            return path[i-1] + (path[i] - path[i-1]) * (half / piece);
         }
+        half -= piece;
     }
+    return path.back();
+}
+
+void AntennaDetector::placeFeedPoints(std::vector<AntennaWire>& wires) const {
+    if (wires.empty() || wires.front().component.empty()) return;
     
-    if (vertexCount == 0) return 0.0;
+    // Everything that is not itself a wire counts as structure
+    const ComponentMesh& source = *wires.front().component.source;
+    std::vector<uint8_t> isWire(source.components.size(), 0);
+    for (const auto& wire : wires) {
+        isWire[wire.component.componentId] = 1;
+    }
+    std::vector<uint32_t> structureFaces;
+    for (uint32_t f = 0; f < source.components.faceComponent.size(); ++f) {
+        if (!isWire[source.components.faceComponent[f]]) {
+            structureFaces.push_back(f);
+        }
+    }
+    IndexedMesh structure = MeshTopology::extractFaces(source.mesh, structureFaces.data(),
+                                                       structureFaces.data() + structureFaces.size());
+    MeshBVH bvh(structure);
     
-    center = center * (1.0 / vertexCount);
+    auto attached = [&](const Point3D& point, double distance) {
+        return std::fabs(point.z) <= distance || bvh.nearest(point, distance).found();
+    };
     
-    double totalDistance = 0.0;
-    for (const auto& triangle : component) {
-        for (const auto& vertex : triangle.vertices) {
-            totalDistance += center.distance(vertex);
+    ThreadPool::getInstance().parallelFor(wires.size(), [&](size_t begin, size_t end) {
+        for (size_t w = begin; w < end; ++w) {
+            AntennaWire& wire = wires[w];
+            double distance = attachDistance(wire.radius);
+            wire.feedPoint = chooseFeedPoint(wire.path, attached(wire.path.front(), distance),
+                                             attached(wire.path.back(), distance));
         }
-    }
+    });
+}
+
+std::vector<ComponentView> AntennaDetector::findWireLikeComponents(const std::vector<Triangle>& triangles) {
+    return separateConnectedComponents(triangles);
+}
+
+bool AntennaDetector::isWireLikeComponent(const ComponentView& component) const {
+    if (component.empty()) return false;
+    
+    // Single pass over the facets, read in place; orientation independent
+    OrientedExtents extents = CovarianceAccumulator::fromComponent(component).getOrientedExtents();
+    
+    // Wire should be thin in two dimensions
+    return extents.crossSectionDiameter <= maxWireDiameter_;
+}
+
+std::vector<Point3D> AntennaDetector::extractWirePath(const ComponentView& component) {
+    std::vector<Point3D> path;
+    
+    if (component.empty()) return path;
+    
+    // Ordered centerline, one point per cross-section ring
+    path = WireSkeleton::extractCenterline(component).path;
     
-    return totalDistance / vertexCount;
+    return simplifyPath(path, pathTolerance_);
 }
 
-double AntennaDetector::calculateWireLength(const std::vector<Point3D>& path) {
+double AntennaDetector::calculateWireRadius(const ComponentView& component) {
+    if (component.empty()) return 0.0;
+    
+    // Mean distance of the tube wall from the centerline
+    return WireSkeleton::extractCenterline(component).radius;
+}
+
+double AntennaDetector::calculateWireLength(const std::vector<Point3D>& path) const {
     if (path.size() < 2) return 0.0;
     
     double totalLength = 0.0;
@@ -125,31 +234,21 @@ double AntennaDetector::calculateWireLength(const std::vector<Point3D>& path) {
     return totalLength;
 }
 
-bool AntennaDetector::isReasonableAntennaLength(double length) {
+bool AntennaDetector::isReasonableAntennaLength(double length) const {
     return length >= minWireLength_ && length <= maxWireLength_;
 }
 
-bool AntennaDetector::isReasonableAntennaRadius(double radius) {
-    return radius > 0.0 && radius <= 0.01; // 1cm max radius
+bool AntennaDetector::isReasonableAntennaRadius(double radius) const {
+    return radius > 0.0 && 2.0 * radius <= maxWireDiameter_;
 }
 
-std::vector<Point3D> AntennaDetector::simplifyPath(const std::vector<Point3D>& path, double tolerance) {
-    if (path.size() <= 2) return path;
-    
-    std::vector<Point3D> simplified;
-    simplified.push_back(path[0]);
-    
-    for (size_t i = 1; i < path.size() - 1; ++i) {
-        if (path[i].distance(simplified.back()) > tolerance) {
-            simplified.push_back(path[i]);
-        }
-    }
-    
-    if (path.size() > 1) {
-        simplified.push_back(path.back());
-    }
-    
-    return simplified;
+std::vector<ComponentView> AntennaDetector::separateConnectedComponents(const std::vector<Triangle>& triangles) {
+    // Weld once; every view refers into the same shared mesh
+    return MeshTopology::componentViews(MeshTopology::buildComponentMesh(triangles));
+}
+
+std::vector<Point3D> AntennaDetector::simplifyPath(const std::vector<Point3D>& path, double tolerance) const {
+    return GeometryUtils::simplifyWirePathDouglasPeucker(path, tolerance);
 }
 
 void AntennaDetector::printAntennaInfo() const {
@@ -167,7 +266,14 @@ void AntennaDetector::printAntennaInfo() const {
     std::cout << "Start point: (" << std::fixed << std::setprecision(3) << antenna_.startPoint.x;
     std::cout << ", " << antenna_.startPoint.y << ", " << antenna_.startPoint.z << ")\n";
     std::cout << "End point: (" << std::fixed << std::setprecision(3) << antenna_.endPoint.x;
-    std::cout << ", " << antenna_.endPoint.y << ", " << antenna_.endPoint.z << ")\n\n";
+    std::cout << ", " << antenna_.endPoint.y << ", " << antenna_.endPoint.z << ")\n";
+    std::cout << "Feed point: (" << std::fixed << std::setprecision(3) << antenna_.feedPoint.x;
+    std::cout << ", " << antenna_.feedPoint.y << ", " << antenna_.feedPoint.z << ")\n";
+    
+    if (antennas_.size() > 1) {
+        std::cout << "Additional candidates: " << antennas_.size() - 1 << "\n";
+    }
+    std::cout << "\n";
 }
 
 } // namespace stl_to_eznec
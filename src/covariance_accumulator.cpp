@@ -0,0 +1,202 @@
+#include "covariance_accumulator.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace stl_to_eznec {
+
+CovarianceAccumulator::CovarianceAccumulator()
+    : weight_(0.0), mean_(0, 0, 0), scatter_{0, 0, 0, 0, 0, 0} {
+}
+
+void CovarianceAccumulator::addMoments(double weight, const Point3D& mean, const std::array<double, 6>& scatter) {
+    if (weight <= 0.0) return;
+
+    if (weight_ <= 0.0) {
+        weight_ = weight;
+        mean_ = mean;
+        scatter_ = scatter;
+        return;
+    }
+
+    double total = weight_ + weight;
+    Point3D delta = mean - mean_;
+    double factor = weight_ * weight / total;
+
+    scatter_[0] += scatter[0] + delta.x * delta.x * factor;
+    scatter_[1] += scatter[1] + delta.x * delta.y * factor;
+    scatter_[2] += scatter[2] + delta.x * delta.z * factor;
+    scatter_[3] += scatter[3] + delta.y * delta.y * factor;
+    scatter_[4] += scatter[4] + delta.y * delta.z * factor;
+    scatter_[5] += scatter[5] + delta.z * delta.z * factor;
+
+    mean_ = mean_ + delta * (weight / total);
+    weight_ = total;
+}
+
+void CovarianceAccumulator::addPoint(const Point3D& point, double weight) {
+    addMoments(weight, point, {0, 0, 0, 0, 0, 0});
+}
+
+void CovarianceAccumulator::addTriangle(const Triangle& triangle) {
+    addTriangle(triangle.vertices[0], triangle.vertices[1], triangle.vertices[2]);
+}
+
+void CovarianceAccumulator::addTriangle(const Point3D& a, const Point3D& b, const Point3D& c) {
+    Point3D e1 = b - a;
+    Point3D e2 = c - a;
+    double cx = e1.y * e2.z - e1.z * e2.y;
+    double cy = e1.z * e2.x - e1.x * e2.z;
+    double cz = e1.x * e2.y - e1.y * e2.x;
+    double area = std::sqrt(cx*cx + cy*cy + cz*cz) / 2.0;
+    if (area <= 0.0) return;
+
+    // Second moment of a uniform triangle about its centroid: A/12 * sum(d d^T)
+    Point3D centroid = (a + b + c) * (1.0 / 3.0);
+    std::array<double, 6> scatter = {0, 0, 0, 0, 0, 0};
+    for (const Point3D* vertex : {&a, &b, &c}) {
+        Point3D d = *vertex - centroid;
+        scatter[0] += d.x * d.x;
+        scatter[1] += d.x * d.y;
+        scatter[2] += d.x * d.z;
+        scatter[3] += d.y * d.y;
+        scatter[4] += d.y * d.z;
+        scatter[5] += d.z * d.z;
+    }
+    for (auto& value : scatter) {
+        value *= area / 12.0;
+    }
+
+    addMoments(area, centroid, scatter);
+}
+
+void CovarianceAccumulator::merge(const CovarianceAccumulator& other) {
+    addMoments(other.weight_, other.mean_, other.scatter_);
+}
+
+std::array<double, 9> CovarianceAccumulator::getCovariance() const {
+    std::array<double, 9> covariance = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+    if (weight_ <= 0.0) return covariance;
+
+    double inverse = 1.0 / weight_;
+    covariance[0] = scatter_[0] * inverse;
+    covariance[1] = covariance[3] = scatter_[1] * inverse;
+    covariance[2] = covariance[6] = scatter_[2] * inverse;
+    covariance[4] = scatter_[3] * inverse;
+    covariance[5] = covariance[7] = scatter_[4] * inverse;
+    covariance[8] = scatter_[5] * inverse;
+    return covariance;
+}
+
+OrientedExtents CovarianceAccumulator::getOrientedExtents() const {
+    OrientedExtents result;
+    result.center = mean_;
+    result.axes = {Point3D(1, 0, 0), Point3D(0, 1, 0), Point3D(0, 0, 1)};
+
+    if (weight_ <= 0.0) return result;
+
+    eigenDecompose(getCovariance(), result.variances, result.axes);
+
+    for (int i = 0; i < 3; ++i) {
+        result.variances[i] = std::max(result.variances[i], 0.0);
+        result.extents[i] = std::sqrt(12.0 * result.variances[i]);
+    }
+
+    result.length = result.extents[0];
+    result.crossSectionDiameter = 2.0 * std::sqrt(result.variances[1] + result.variances[2]);
+    result.aspectRatio = result.crossSectionDiameter > 0.0 ? result.length / result.crossSectionDiameter : 0.0;
+
+    return result;
+}
+
+CovarianceAccumulator CovarianceAccumulator::fromTriangles(const std::vector<Triangle>& triangles) {
+    const size_t BLOCK = 65536;
+    size_t blockCount = (triangles.size() + BLOCK - 1) / BLOCK;
+
+    // Fixed blocks on the shared pool; small inputs stay on this thread
+    std::vector<CovarianceAccumulator> partial(blockCount);
+    ThreadPool::getInstance().parallelFor(blockCount, [&](size_t begin, size_t end) {
+        for (size_t block = begin; block < end; ++block) {
+            size_t last = std::min(triangles.size(), (block + 1) * BLOCK);
+            for (size_t i = block * BLOCK; i < last; ++i) {
+                partial[block].addTriangle(triangles[i]);
+            }
+        }
+    });
+
+    // Merge in block order so results do not depend on the thread count
+    CovarianceAccumulator result;
+    for (const auto& accumulator : partial) {
+        result.merge(accumulator);
+    }
+    return result;
+}
+
+CovarianceAccumulator CovarianceAccumulator::fromComponent(const ComponentView& component) {
+    CovarianceAccumulator result;
+    if (component.empty()) return result;
+
+    const IndexedMesh& mesh = component.mesh();
+    for (uint32_t face : component) {
+        const auto& f = mesh.faces[face];
+        result.addTriangle(mesh.vertices[f[0]], mesh.vertices[f[1]], mesh.vertices[f[2]]);
+    }
+    return result;
+}
+
+void CovarianceAccumulator::eigenDecompose(const std::array<double, 9>& matrix, std::array<double, 3>& eigenvalues, std::array<Point3D, 3>& eigenvectors) {
+    double a[3][3] = {
+        {matrix[0], matrix[1], matrix[2]},
+        {matrix[3], matrix[4], matrix[5]},
+        {matrix[6], matrix[7], matrix[8]}
+    };
+    double v[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+    for (int sweep = 0; sweep < 50; ++sweep) {
+        double offDiagonal = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+        double diagonal = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+        if (offDiagonal <= 1e-30 * diagonal || offDiagonal == 0.0) break;
+
+        for (int p = 0; p < 2; ++p) {
+            for (int q = p + 1; q < 3; ++q) {
+                if (a[p][q] == 0.0) continue;
+
+                double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                double t = (theta >= 0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                double c = 1.0 / std::sqrt(t * t + 1.0);
+                double s = t * c;
+
+                for (int k = 0; k < 3; ++k) {
+                    double akp = a[k][p];
+                    double akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    double apk = a[p][k];
+                    double aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    double vkp = v[k][p];
+                    double vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    // Sort by descending eigenvalue
+    std::array<int, 3> order = {0, 1, 2};
+    std::sort(order.begin(), order.end(), [&a](int i, int j) { return a[i][i] > a[j][j]; });
+
+    for (int i = 0; i < 3; ++i) {
+        int column = order[i];
+        eigenvalues[i] = a[column][column];
+        eigenvectors[i] = Point3D(v[0][column], v[1][column], v[2][column]);
+    }
+}
+
+} // namespace stl_to_eznec
@@ -0,0 +1,288 @@
+#include "deck_serializer.h"
+#include <iomanip>
+#include <sstream>
+
+namespace stl_to_eznec {
+
+DeckSerializer::DeckSerializer(PatchPolicy patchPolicy)
+    : patchPolicy_(patchPolicy), includeComments_(true), includePattern_(true), includeCurrent_(false) {
+}
+
+size_t DeckSerializer::cardCount(const WireModel& model) const {
+    return model.cardCount(patchPolicy_ == PatchPolicy::SurfacePatches);
+}
+
+void DeckSerializer::write(DeckWriter& out, const WireModel& model) const {
+    if (model.structureOnly) {
+        out.write(generateStructureOnlyHeader(model.modelName, model.material));
+        writeGeometry(out, model);
+        out.write("EN\n");
+        return;
+    }
+
+    // Generate header
+    out.write(generateHeader(model));
+
+    // Generate geometry
+    writeGeometry(out, model);
+
+    // Generate loads and excitation
+    writeLoads(out, model.loads);
+    writeExcitations(out, model.excitations);
+
+    // Generate ground
+    writeGround(out, model);
+
+    // Generate frequency
+    out.write(generateFrequency(model.frequency));
+
+    // Generate pattern
+    if (includePattern_) {
+        out.write("RP 0 37 73 1000 0.0 0.0 5.0 5.0\n\n");
+    }
+
+    // Generate current
+    if (includeCurrent_) {
+        out.write("NH 0 0 0 0 0 0 0 0 0\n\n");
+    }
+
+    out.write("EN\n");
+}
+
+std::string DeckSerializer::generateHeader(const WireModel& model) const {
+    const FrequencyCalculator& frequency = model.frequency;
+    std::stringstream header;
+
+    if (includeComments_) {
+        header << "CM ================================================================\n";
+        header << "CM " << model.modelName << "\n";
+        header << "CM Generated by STL-to-EZ/NEC Converter\n";
+        header << "CM Date: " << __DATE__ << " " << __TIME__ << "\n";
+        header << "CM ================================================================\n";
+        header << "CM\n";
+
+        if (frequency.isValidFrequency()) {
+            header << "CM Frequency: " << std::fixed << std::setprecision(1) << frequency.getFrequencyMHz() << " MHz\n";
+            header << "CM Wavelength: " << std::fixed << std::setprecision(3) << frequency.getWavelength() << " m\n";
+            header << "CM Band: " << frequency.getFrequencyBand() << "\n";
+        }
+
+        // The pitch the grid was built at, as a range when it is graded
+        if (model.gridSpacing > 0.0) {
+            header << "CM Grid Spacing: " << std::fixed << std::setprecision(1) << model.gridSpacing * 100.0;
+            if (model.farGridSpacing > model.gridSpacing) {
+                header << " to " << model.farGridSpacing * 100.0;
+            }
+            header << " cm\n";
+        }
+
+        header << "CM ================================================================\n";
+        header << "CE\n\n";
+    }
+
+    return header.str();
+}
+
+std::string DeckSerializer::generateStructureOnlyHeader(const std::string& modelName,
+                                                        const MaterialProperties& material) const {
+    std::stringstream header;
+    header << "CM ================================================================\n";
+    header << "CM " << modelName << " - Structure Only\n";
+    header << "CM Generated by STL-to-EZ/NEC Converter\n";
+    header << "CM Date: " << __DATE__ << " " << __TIME__ << "\n";
+    header << "CM ================================================================\n";
+    header << "CM\n";
+    header << "CM Material: " << material.name << "\n";
+    header << "CM Conductivity: " << std::scientific << std::setprecision(2) << material.conductivity << " S/m\n";
+    header << "CM Relative Permittivity: " << std::fixed << std::setprecision(1) << material.relativePermittivity << "\n";
+    header << "CM ================================================================\n";
+    header << "CE\n\n";
+    return header.str();
+}
+
+void DeckSerializer::writeGeometry(DeckWriter& out, const WireModel& model) const {
+    out.write("GE 0\n");
+
+    writeWires(out, model);
+
+    // Patches follow every wire: as SP/SC cards, or as their stand-in wire
+    // grid tagged after the wires for formats without patches
+    int tagCount = model.tagCount;
+    bool hasPatches = false;
+    if (patchPolicy_ == PatchPolicy::SurfacePatches) {
+        writeSurfacePatches(out, model.patches);
+        hasPatches = !model.patches.faces.empty();
+    } else {
+        out.writeChunks(model.patchWires.size(), [&](DeckWriter& chunk, size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                writeWire(chunk, model.patchWires, i);
+            }
+        });
+        tagCount += static_cast<int>(model.patchWires.size());
+    }
+
+    // Reflect the stored half across its mirror plane
+    if (model.mirrorAxis >= 0 && (tagCount > 0 || hasPatches)) {
+        const char* planes[] = {"100", "010", "001"};
+        out.write("GX ", 3);
+        out.writeInt(tagCount);
+        out.put(' ');
+        out.write(planes[model.mirrorAxis], 3);
+        out.put('\n');
+    }
+
+    out.write("GE 1\n\n");
+}
+
+void DeckSerializer::writeWires(DeckWriter& out, const WireModel& model) const {
+    // Runs of GW cards are formatted in parallel chunks, in tag order
+    auto writeRun = [&](size_t begin, size_t end) {
+        out.writeChunks(end - begin, [&](DeckWriter& chunk, size_t first, size_t last) {
+            for (size_t i = begin + first; i < begin + last; ++i) {
+                writeWire(chunk, model.wires, i);
+            }
+        });
+    };
+
+    writeRun(0, model.antennaWires);
+    size_t next = model.antennaWires;
+
+    // Add material properties comment
+    out.write(getMaterialComment(model.material) + "\n");
+
+    for (const auto& replication : model.replications) {
+        writeRun(next, replication.wireEnd);
+        next = replication.wireEnd;
+
+        int tagCount = static_cast<int>(replication.wireEnd - replication.wireBegin);
+        if (replication.rotational) {
+            out.write("GR ", 3);
+            out.writeInt(tagCount);
+            out.put(' ');
+            out.writeInt(replication.copies + 1);
+        } else {
+            out.write("GM ", 3);
+            out.writeInt(tagCount);
+            out.put(' ');
+            out.writeInt(replication.copies);
+            for (double value : {0.0, 0.0, replication.rotateZDegrees, replication.translation.x,
+                                 replication.translation.y, replication.translation.z}) {
+                out.put(' ');
+                out.writeFixed(value, COORDINATE_PRECISION);
+            }
+            out.put(' ');
+            out.writeInt(model.wires.tags[replication.wireBegin]);
+        }
+        out.put('\n');
+    }
+    writeRun(next, model.wires.size());
+}
+
+void DeckSerializer::writeSurfacePatches(DeckWriter& out, const IndexedMesh& patches) const {
+    // Triangular patch: corners 1 and 2 on SP, corner 3 on SC; the outward
+    // normal is (r2 - r1) x (r3 - r2)
+    out.writeChunks(patches.faceCount(), [&](DeckWriter& chunk, size_t first, size_t last) {
+        for (size_t f = first; f < last; ++f) {
+            const auto& face = patches.faces[f];
+            const Point3D& a = patches.vertices[face[0]];
+            const Point3D& b = patches.vertices[face[1]];
+            const Point3D& c = patches.vertices[face[2]];
+
+            chunk.write("SP 0 2", 6);
+            for (double value : {a.x, a.y, a.z, b.x, b.y, b.z}) {
+                chunk.put(' ');
+                chunk.writeFixed(value, COORDINATE_PRECISION);
+            }
+            chunk.write("\nSC 0 0", 7);
+            for (double value : {c.x, c.y, c.z, 0.0, 0.0, 0.0}) {
+                chunk.put(' ');
+                chunk.writeFixed(value, COORDINATE_PRECISION);
+            }
+            chunk.put('\n');
+        }
+    });
+}
+
+void DeckSerializer::writeLoads(DeckWriter& out, const std::vector<NECLoad>& loads) const {
+    for (const auto& load : loads) {
+        out.write("LD ", 3);
+        for (int value : {load.type, load.wireTag, load.segStart, load.segEnd}) {
+            out.writeInt(value);
+            out.put(' ');
+        }
+        out.writeScientific(load.R, 4);
+        out.put(' ');
+        out.writeScientific(load.L, 4);
+        out.put(' ');
+        out.writeScientific(load.C, 4);
+        out.put('\n');
+    }
+    if (!loads.empty()) {
+        out.put('\n');
+    }
+}
+
+void DeckSerializer::writeExcitations(DeckWriter& out, const std::vector<NECExcitation>& excitations) const {
+    for (const auto& excitation : excitations) {
+        out.write("EX 0 ", 5);
+        out.writeInt(excitation.wireTag);
+        out.put(' ');
+        out.writeInt(excitation.segment);
+        out.write(" 0 ", 3);
+        out.writeFixed(excitation.real, 1);
+        out.put(' ');
+        out.writeFixed(excitation.imaginary, 1);
+        out.put('\n');
+    }
+    if (!excitations.empty()) {
+        out.put('\n');
+    }
+}
+
+void DeckSerializer::writeGround(DeckWriter& out, const WireModel& model) const {
+    if (model.groundType == 2) {
+        // Marine ground with water properties
+        out.write("GN 2 0 0 0 ", 11);
+        out.writeFixed(model.groundPermittivity, 1);
+        out.put(' ');
+        out.writeScientific(model.groundConductivity, 2);
+        out.write("\n\n", 2);
+    } else {
+        // Perfect ground
+        out.write("GN -1\n\n");
+    }
+}
+
+std::string DeckSerializer::generateFrequency(const FrequencyCalculator& frequency) const {
+    std::stringstream freq;
+
+    if (frequency.isValidFrequency()) {
+        freq << "FR 0 1 0 0 " << std::fixed << std::setprecision(1) << frequency.getFrequencyMHz() << "\n\n";
+    }
+
+    return freq.str();
+}
+
+void DeckSerializer::writeWire(DeckWriter& out, const NECDeck& wires, size_t index) const {
+    const Point3D& start = wires.starts[index];
+    const Point3D& end = wires.ends[index];
+    out.write("GW ", 3);
+    out.writeInt(wires.tags[index]);
+    out.put(' ');
+    out.writeInt(wires.segments[index]);
+    for (double value : {start.x, start.y, start.z, end.x, end.y, end.z, wires.radii[index]}) {
+        out.put(' ');
+        out.writeFixed(value, COORDINATE_PRECISION);
+    }
+    out.put('\n');
+}
+
+std::string DeckSerializer::getMaterialComment(const MaterialProperties& material) const {
+    std::stringstream comment;
+    comment << "CM Material: " << material.name;
+    comment << " (σ = " << std::scientific << std::setprecision(1) << material.conductivity;
+    comment << " S/m, εᵣ = " << std::fixed << std::setprecision(1) << material.relativePermittivity << ")";
+    return comment.str();
+}
+
+} // namespace stl_to_eznec
@@ -0,0 +1,181 @@
+#include "deck_writer.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace stl_to_eznec {
+
+DeckWriter::DeckWriter(size_t capacity)
+    : buffer_(std::max<size_t>(capacity, 1)), used_(0), bytesWritten_(0), fd_(-1), target_(nullptr), failed_(false) {
+}
+
+DeckWriter::DeckWriter(std::string& target, size_t capacity)
+    : buffer_(std::max<size_t>(capacity, 1)), used_(0), bytesWritten_(0), fd_(-1), target_(&target), failed_(false) {
+}
+
+DeckWriter::~DeckWriter() {
+    close();
+}
+
+bool DeckWriter::open(const std::string& filename) {
+    close();
+    target_ = nullptr;
+    used_ = 0;
+    bytesWritten_ = 0;
+    fd_ = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    failed_ = fd_ < 0;
+    return !failed_;
+}
+
+bool DeckWriter::close() {
+    flush();
+    if (fd_ >= 0) {
+        if (::close(fd_) != 0) failed_ = true;
+        fd_ = -1;
+    }
+    target_ = nullptr;
+    return !failed_;
+}
+
+void DeckWriter::reserveCards(size_t cards) {
+    const size_t MIN_CAPACITY = 64 << 10;
+    const size_t MAX_CAPACITY = 16 << 20;
+    size_t capacity = std::min(std::max(cards * CARD_BYTES, MIN_CAPACITY), MAX_CAPACITY);
+    if (capacity > buffer_.size()) {
+        buffer_.resize(capacity);
+    }
+}
+
+void DeckWriter::write(const char* data, size_t length) {
+    if (used_ + length > buffer_.size()) {
+        flush();
+        // Larger than the whole buffer: pass it straight through
+        if (length > buffer_.size()) {
+            sink(data, length);
+            return;
+        }
+    }
+    std::memcpy(buffer_.data() + used_, data, length);
+    used_ += length;
+}
+
+void DeckWriter::writeInt(long long value) {
+    // 20 digits and a sign
+    if (buffer_.size() - used_ < 21) flush();
+    if (buffer_.size() - used_ < 21) {
+        write(std::to_string(value));
+        return;
+    }
+    char* begin = buffer_.data() + used_;
+    used_ += std::to_chars(begin, begin + 21, value).ptr - begin;
+}
+
+void DeckWriter::writeFixed(double value, int precision) {
+    writeNumber(value, precision, false);
+}
+
+void DeckWriter::writeScientific(double value, int precision) {
+    writeNumber(value, precision, true);
+}
+
+void DeckWriter::writeNumber(double value, int precision, bool exponential) {
+    // Coordinates fit in a few dozen characters; only huge fixed values
+    // take the slow path
+    const size_t TYPICAL = 64;
+    if (buffer_.size() - used_ < TYPICAL) flush();
+    size_t length = 0;
+    if (buffer_.size() - used_ >= TYPICAL) {
+        char* begin = buffer_.data() + used_;
+        length = exponential ? formatScientific(begin, TYPICAL, value, precision)
+                            : formatFixed(begin, TYPICAL, value, precision);
+    }
+    if (length > 0) {
+        used_ += length;
+    } else {
+        write(exponential ? scientific(value, precision) : fixed(value, precision));
+    }
+}
+
+size_t DeckWriter::formatFixed(char* out, size_t size, double value, int precision) {
+    auto result = std::to_chars(out, out + size, value, std::chars_format::fixed, precision);
+    return result.ec == std::errc() ? static_cast<size_t>(result.ptr - out) : 0;
+}
+
+size_t DeckWriter::formatScientific(char* out, size_t size, double value, int precision) {
+    auto result = std::to_chars(out, out + size, value, std::chars_format::scientific, precision);
+    return result.ec == std::errc() ? static_cast<size_t>(result.ptr - out) : 0;
+}
+
+std::string DeckWriter::fixed(double value, int precision) {
+    // The largest double has 309 integer digits
+    char text[360 + 64];
+    size_t length = formatFixed(text, sizeof(text), value, std::min(precision, 60));
+    return std::string(text, length);
+}
+
+std::string DeckWriter::scientific(double value, int precision) {
+    char text[128];
+    size_t length = formatScientific(text, sizeof(text), value, std::min(precision, 100));
+    return std::string(text, length);
+}
+
+void DeckWriter::writeChunks(size_t count, const std::function<void(DeckWriter&, size_t, size_t)>& format,
+                             size_t batchSize) {
+    const size_t MIN_CHUNK = 1024;
+    ThreadPool& pool = ThreadPool::getInstance();
+    if (count < 2 * MIN_CHUNK || pool.getThreadCount() < 2) {
+        format(*this, 0, count);
+        return;
+    }
+
+    batchSize = std::max(batchSize, MIN_CHUNK);
+    chunks_.resize(pool.getThreadCount() * 4);
+    for (size_t batchBegin = 0; batchBegin < count; batchBegin += batchSize) {
+        size_t items = std::min(batchSize, count - batchBegin);
+        size_t chunkCount = std::min(chunks_.size(), std::max<size_t>(1, items / MIN_CHUNK));
+
+        pool.parallelFor(chunkCount, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; ++c) {
+                chunks_[c].clear();
+                DeckWriter chunk(chunks_[c], (items / chunkCount + 1) * CARD_BYTES);
+                format(chunk, batchBegin + items * c / chunkCount, batchBegin + items * (c + 1) / chunkCount);
+                chunk.close();
+            }
+        }, 1);
+
+        for (size_t c = 0; c < chunkCount; ++c) {
+            write(chunks_[c]);
+        }
+    }
+}
+
+void DeckWriter::flush() {
+    if (used_ == 0) return;
+    sink(buffer_.data(), used_);
+    used_ = 0;
+}
+
+void DeckWriter::sink(const char* data, size_t length) {
+    if (target_ != nullptr) {
+        target_->append(data, length);
+    } else if (fd_ >= 0 && !failed_) {
+        size_t remaining = length;
+        while (remaining > 0) {
+            ssize_t written = ::write(fd_, data, remaining);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                failed_ = true;
+                break;
+            }
+            data += written;
+            remaining -= static_cast<size_t>(written);
+        }
+    }
+    bytesWritten_ += length;
+}
+
+} // namespace stl_to_eznec
@@ -1,7 +1,11 @@
 #include "geometry_utils.h"
+#include "mesh_topology.h"
+#include "wire_skeleton.h"
+#include "covariance_accumulator.h"
 #include <algorithm>
 #include <cmath>
 #include <map>
+#include <cstdint>
 
 namespace stl_to_eznec {
 
@@ -34,15 +38,11 @@ double GeometryUtils::calculateTotalLength(const std::vector<Triangle>& triangle
 bool GeometryUtils::isWireLike(const std::vector<Triangle>& triangles, double maxDiameter) {
     if (triangles.empty()) return false;
     
-    BoundingBox bbox = calculateBoundingBox(triangles);
-    Point3D size = bbox.size();
-    
-    // Check if it's thin in two dimensions (wire-like)
-    std::vector<double> dimensions = {size.x, size.y, size.z};
-    std::sort(dimensions.begin(), dimensions.end());
+    // Oriented extents, so wires at any angle are measured across their own axis
+    OrientedExtents extents = CovarianceAccumulator::fromTriangles(triangles).getOrientedExtents();
     
     // Wire should be thin in two dimensions
-    return (dimensions[0] <= maxDiameter && dimensions[1] <= maxDiameter);
+    return extents.crossSectionDiameter <= maxDiameter;
 }
 
 std::vector<Point3D> GeometryUtils::extractWirePath(const std::vector<Triangle>& triangles) {
@@ -50,41 +50,15 @@ std::vector<Point3D> GeometryUtils::extractWirePath(const std::vector<Triangle>&
     
     if (triangles.empty()) return path;
     
-    // For now, return the centers of triangles as a simple path
-    // In a more sophisticated implementation, we would trace the actual wire path
-    for (const auto& triangle : triangles) {
-        path.push_back(triangle.center());
-    }
-    
-    return path;
+    // Ordered centerline, one point per cross-section ring
+    return WireSkeleton::extractCenterline(triangles).path;
 }
 
 double GeometryUtils::calculateWireRadius(const std::vector<Triangle>& triangles) {
     if (triangles.empty()) return 0.0;
     
-    // Calculate average distance from center to vertices
-    Point3D center(0, 0, 0);
-    int vertexCount = 0;
-    
-    for (const auto& triangle : triangles) {
-        for (const auto& vertex : triangle.vertices) {
-            center = center + vertex;
-            vertexCount++;
-        }
-    }
-    
-    if (vertexCount == 0) return 0.0;
-    
-    center = center * (1.0 / vertexCount);
-    
-    double totalDistance = 0.0;
-    for (const auto& triangle : triangles) {
-        for (const auto& vertex : triangle.vertices) {
-            totalDistance += center.distance(vertex);
-        }
-    }
-    
-    return totalDistance / vertexCount;
+    // Mean distance of the tube wall from the centerline
+    return WireSkeleton::extractCenterline(triangles).radius;
 }
 
 bool GeometryUtils::arePointsCoincident(const Point3D& p1, const Point3D& p2, double tolerance) {
@@ -96,10 +70,12 @@ std::vector<std::vector<Triangle>> GeometryUtils::separateConnectedComponents(co
     
     if (triangles.empty()) return components;
     
-    // Simple implementation: each triangle is its own component
-    // In a more sophisticated implementation, we would group connected triangles
-    for (const auto& triangle : triangles) {
-        components.push_back({triangle});
+    IndexedMesh mesh = MeshTopology::buildIndexedMesh(triangles);
+    ComponentTable table = MeshTopology::findConnectedComponents(mesh);
+    
+    components.reserve(table.size());
+    for (size_t c = 0; c < table.size(); ++c) {
+        components.push_back(MeshTopology::extractComponent(mesh, table, c));
     }
     
     return components;
@@ -128,24 +104,67 @@ std::vector<Point3D> GeometryUtils::extractWirePathAdvanced(const std::vector<Tr
 }
 
 std::vector<Point3D> GeometryUtils::simplifyWirePath(const std::vector<Point3D>& path, double tolerance) {
+    return simplifyWirePathDouglasPeucker(path, tolerance);
+}
+
+std::vector<Point3D> GeometryUtils::simplifyWirePathDouglasPeucker(const std::vector<Point3D>& path, double tolerance) {
     if (path.size() <= 2) return path;
     
-    std::vector<Point3D> simplified;
-    simplified.push_back(path[0]);
+    std::vector<uint8_t> keep(path.size(), 0);
+    keep.front() = 1;
+    keep.back() = 1;
     
-    for (size_t i = 1; i < path.size() - 1; ++i) {
-        if (path[i].distance(simplified.back()) > tolerance) {
-            simplified.push_back(path[i]);
+    // Explicit stack of [first, last] spans instead of recursion; a straight run
+    // is settled by a single scan, so the common case stays linear
+    std::vector<std::pair<size_t, size_t>> spans;
+    spans.emplace_back(0, path.size() - 1);
+    
+    while (!spans.empty()) {
+        size_t first = spans.back().first;
+        size_t last = spans.back().second;
+        spans.pop_back();
+        
+        if (last <= first + 1) continue;
+        
+        double maxDistance = -1.0;
+        size_t farthest = first;
+        for (size_t i = first + 1; i < last; ++i) {
+            double distance = pointSegmentDistance(path[i], path[first], path[last]);
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                farthest = i;
+            }
+        }
+        
+        if (maxDistance > tolerance) {
+            keep[farthest] = 1;
+            spans.emplace_back(first, farthest);
+            spans.emplace_back(farthest, last);
         }
     }
     
-    if (path.size() > 1) {
-        simplified.push_back(path.back());
+    std::vector<Point3D> simplified;
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (keep[i]) {
+            simplified.push_back(path[i]);
+        }
     }
     
     return simplified;
 }
 
+double GeometryUtils::pointSegmentDistance(const Point3D& point, const Point3D& start, const Point3D& end) {
+    Point3D segment = end - start;
+    Point3D offset = point - start;
+    double lengthSquared = segment.x*segment.x + segment.y*segment.y + segment.z*segment.z;
+    
+    if (lengthSquared <= 0.0) return point.distance(start);
+    
+    double t = (offset.x*segment.x + offset.y*segment.y + offset.z*segment.z) / lengthSquared;
+    t = std::max(0.0, std::min(1.0, t));
+    return point.distance(start + segment * t);
+}
+
 double GeometryUtils::calculateWireLength(const std::vector<Point3D>& path) {
     if (path.size() < 2) return 0.0;
     
@@ -160,19 +179,13 @@ double GeometryUtils::calculateWireLength(const std::vector<Point3D>& path) {
 bool GeometryUtils::isReasonableWireGeometry(const std::vector<Triangle>& triangles) {
     if (triangles.empty()) return false;
     
-    BoundingBox bbox = calculateBoundingBox(triangles);
-    Point3D size = bbox.size();
+    OrientedExtents extents = CovarianceAccumulator::fromTriangles(triangles).getOrientedExtents();
     
     // Check aspect ratio
-    double aspectRatio = calculateWireAspectRatio(triangles);
-    if (aspectRatio < 5.0) return false; // Not wire-like enough
-    
-    // Check dimensions
-    std::vector<double> dimensions = {size.x, size.y, size.z};
-    std::sort(dimensions.begin(), dimensions.end());
+    if (extents.aspectRatio < 5.0) return false; // Not wire-like enough
     
     // Wire should be thin in two dimensions
-    return (dimensions[0] <= 0.01 && dimensions[1] <= 0.01);
+    return extents.crossSectionDiameter <= 0.01;
 }
 
 std::vector<Point3D> GeometryUtils::findWireEndpoints(const std::vector<Triangle>& triangles) {
@@ -202,15 +215,8 @@ std::vector<Point3D> GeometryUtils::findWireEndpoints(const std::vector<Triangle
 double GeometryUtils::calculateWireAspectRatio(const std::vector<Triangle>& triangles) {
     if (triangles.empty()) return 0.0;
     
-    BoundingBox bbox = calculateBoundingBox(triangles);
-    Point3D size = bbox.size();
-    
-    std::vector<double> dimensions = {size.x, size.y, size.z};
-    std::sort(dimensions.begin(), dimensions.end());
-    
-    if (dimensions[0] == 0) return 0.0;
-    
-    return dimensions[2] / dimensions[0]; // Length / width
+    // Length / width along the principal axes
+    return CovarianceAccumulator::fromTriangles(triangles).getOrientedExtents().aspectRatio;
 }
 
 std::vector<Point3D> GeometryUtils::interpolateWirePath(const std::vector<Point3D>& path, int segments) {
@@ -0,0 +1,300 @@
+#include "instance_detector.h"
+#include "covariance_accumulator.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace stl_to_eznec {
+
+namespace {
+
+struct Fingerprint {
+    uint32_t faceCount;
+    uint32_t vertexCount;
+    double area;
+    double size;                        // Rotation-invariant diameter from the extents
+    Point3D centroid;
+    std::array<double, 3> variances;
+    std::vector<uint32_t> vertexIds;
+};
+
+// A component confirmed as a rigid copy of its group's first member
+struct Member {
+    uint32_t component;
+    size_t slot;                        // Position in the group
+    double theta;                       // Rotation about z relative to the first member
+    Point3D centroid;
+};
+
+double wrapAngle(double angle) {
+    angle = std::fmod(angle + M_PI, 2.0 * M_PI);
+    if (angle < 0.0) angle += 2.0 * M_PI;
+    return angle - M_PI;
+}
+
+Point3D rotateZ(const Point3D& p, double theta) {
+    double c = std::cos(theta);
+    double s = std::sin(theta);
+    return Point3D(p.x * c - p.y * s, p.x * s + p.y * c, p.z);
+}
+
+double radiusXY(const Point3D& p) {
+    return std::sqrt(p.x * p.x + p.y * p.y);
+}
+
+} // namespace
+
+InstanceDetector::InstanceDetector()
+    : tolerance_(1e-3), minExtent_(0.0) {
+}
+
+InstanceSet InstanceDetector::detect(const IndexedMesh& mesh) const {
+    InstanceSet result;
+    ComponentTable components = MeshTopology::findConnectedComponents(mesh);
+    size_t componentCount = components.size();
+
+    std::vector<Fingerprint> prints(componentCount);
+    ThreadPool::getInstance().parallelFor(componentCount, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            Fingerprint& print = prints[c];
+            CovarianceAccumulator moments;
+            for (uint32_t i = components.offsets[c]; i < components.offsets[c + 1]; ++i) {
+                const auto& face = mesh.faces[components.faces[i]];
+                moments.addTriangle(mesh.vertices[face[0]], mesh.vertices[face[1]], mesh.vertices[face[2]]);
+                print.vertexIds.insert(print.vertexIds.end(), face.begin(), face.end());
+            }
+            std::sort(print.vertexIds.begin(), print.vertexIds.end());
+            print.vertexIds.erase(std::unique(print.vertexIds.begin(), print.vertexIds.end()), print.vertexIds.end());
+
+            OrientedExtents extents = moments.getOrientedExtents();
+            print.faceCount = components.faceCount(c);
+            print.vertexCount = static_cast<uint32_t>(print.vertexIds.size());
+            print.area = moments.getWeight();
+            print.size = std::sqrt(extents.extents[0] * extents.extents[0] + extents.extents[1] * extents.extents[1] +
+                                   extents.extents[2] * extents.extents[2]);
+            print.centroid = moments.getMean();
+            print.variances = extents.variances;
+        }
+    });
+
+    // Candidates sorted so equal fingerprints sit next to each other
+    std::vector<uint32_t> order;
+    for (uint32_t c = 0; c < componentCount; ++c) {
+        if (prints[c].size > 0.0 && prints[c].size >= minExtent_) order.push_back(c);
+    }
+    std::sort(order.begin(), order.end(), [&prints](uint32_t a, uint32_t b) {
+        if (prints[a].faceCount != prints[b].faceCount) return prints[a].faceCount < prints[b].faceCount;
+        if (prints[a].vertexCount != prints[b].vertexCount) return prints[a].vertexCount < prints[b].vertexCount;
+        return prints[a].area < prints[b].area;
+    });
+
+    auto samePrint = [this, &prints](uint32_t a, uint32_t b) {
+        const Fingerprint& p = prints[a];
+        const Fingerprint& q = prints[b];
+        if (p.faceCount != q.faceCount || p.vertexCount != q.vertexCount) return false;
+        if (std::abs(p.area - q.area) > tolerance_ * p.area) return false;
+        for (int i = 0; i < 3; ++i) {
+            if (std::abs(p.variances[i] - q.variances[i]) > tolerance_ * p.variances[0]) return false;
+        }
+        return true;
+    };
+
+    std::vector<std::vector<uint32_t>> groups;
+    std::vector<uint8_t> grouped(componentCount, 0);
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (grouped[order[i]]) continue;
+        std::vector<uint32_t> group{order[i]};
+        for (size_t j = i + 1; j < order.size() && prints[order[j]].faceCount == prints[order[i]].faceCount &&
+                               prints[order[j]].vertexCount == prints[order[i]].vertexCount; ++j) {
+            if (!grouped[order[j]] && samePrint(order[i], order[j])) {
+                grouped[order[j]] = 1;
+                group.push_back(order[j]);
+            }
+        }
+        if (group.size() >= 2) groups.push_back(std::move(group));
+    }
+
+    // Confirm each group member as a rigid copy, then cut the group into runs
+    // that a single repeated step reproduces
+    std::vector<std::vector<InstanceRun>> groupRuns(groups.size());
+    std::vector<std::vector<uint32_t>> groupCovered(groups.size());
+
+    ThreadPool::getInstance().parallelFor(groups.size(), [&](size_t begin, size_t end) {
+        for (size_t g = begin; g < end; ++g) {
+            const std::vector<uint32_t>& group = groups[g];
+            const Fingerprint& first = prints[group[0]];
+            double tolerance = tolerance_ * first.size;
+
+            // Reference vertex farthest from the vertical axis through the centroid
+            Point3D reference(0, 0, 0);
+            for (uint32_t v : first.vertexIds) {
+                Point3D d = mesh.vertices[v] - first.centroid;
+                if (radiusXY(d) > radiusXY(reference)) reference = d;
+            }
+
+            std::vector<SpatialHash> hashes;
+            hashes.reserve(group.size());
+            for (uint32_t c : group) {
+                hashes.emplace_back(tolerance);
+                hashes.back().reserve(prints[c].vertexIds.size());
+                for (uint32_t v : prints[c].vertexIds) {
+                    hashes.back().insert(mesh.vertices[v], v);
+                }
+            }
+
+            // Does the first member, turned by theta about its centroid, land on group[slot]?
+            auto fits = [&](size_t slot, double theta) {
+                const Point3D& centroid = prints[group[slot]].centroid;
+                for (uint32_t v : first.vertexIds) {
+                    Point3D mapped = rotateZ(mesh.vertices[v] - first.centroid, theta) + centroid;
+                    if (hashes[slot].findNear(mapped, tolerance) < 0) return false;
+                }
+                return true;
+            };
+
+            std::vector<Member> members{{group[0], 0, 0.0, first.centroid}};
+            for (size_t m = 1; m < group.size(); ++m) {
+                const Fingerprint& other = prints[group[m]];
+
+                // Any valid rotation carries the reference vertex onto one at the
+                // same radius and height, so those give the candidate angles
+                std::vector<double> candidates{0.0};
+                if (radiusXY(reference) > tolerance) {
+                    for (uint32_t v : other.vertexIds) {
+                        Point3D d = mesh.vertices[v] - other.centroid;
+                        if (std::abs(radiusXY(d) - radiusXY(reference)) <= tolerance &&
+                            std::abs(d.z - reference.z) <= tolerance && candidates.size() < 64) {
+                            candidates.push_back(wrapAngle(std::atan2(d.y, d.x) - std::atan2(reference.y, reference.x)));
+                        }
+                    }
+                }
+
+                for (double theta : candidates) {
+                    if (fits(m, theta)) {
+                        members.push_back({group[m], m, theta, other.centroid});
+                        break;
+                    }
+                }
+            }
+            if (members.size() < 2) continue;
+
+            auto addRun = [&](const std::vector<Member>& run, double step, const Point3D& translation) {
+                InstanceRun instance;
+                const uint32_t* faces = components.faces.data();
+                instance.prototype = MeshTopology::extractFaces(mesh, faces + components.offsets[run[0].component],
+                                                  faces + components.offsets[run[0].component + 1]);
+                instance.copies = static_cast<int>(run.size() - 1);
+                instance.rotateZDegrees = step * 180.0 / M_PI;
+                instance.translation = translation;
+                groupRuns[g].push_back(std::move(instance));
+                for (const auto& member : run) {
+                    groupCovered[g].push_back(member.component);
+                }
+            };
+
+            // A complete ring about a vertical axis: centroids evenly spaced in
+            // angle about their mean and each copy turned by the same angle
+            bool rotated = false;
+            for (const auto& member : members) {
+                if (std::abs(wrapAngle(member.theta)) * first.size > tolerance) rotated = true;
+            }
+            if (rotated) {
+                Point3D center(0, 0, 0);
+                for (const auto& member : members) {
+                    center = center + member.centroid;
+                }
+                center = center * (1.0 / members.size());
+
+                std::vector<Member> ring = members;
+                std::vector<double> phi(ring.size());
+                bool valid = true;
+                double radius = radiusXY(ring[0].centroid - center);
+                for (const auto& member : ring) {
+                    Point3D d = member.centroid - center;
+                    if (std::abs(d.z) > tolerance || std::abs(radiusXY(d) - radius) > tolerance) valid = false;
+                }
+                if (valid && radius > tolerance) {
+                    std::sort(ring.begin(), ring.end(), [&center](const Member& a, const Member& b) {
+                        return std::atan2(a.centroid.y - center.y, a.centroid.x - center.x) <
+                               std::atan2(b.centroid.y - center.y, b.centroid.x - center.x);
+                    });
+                    for (size_t i = 0; i < ring.size(); ++i) {
+                        phi[i] = std::atan2(ring[i].centroid.y - center.y, ring[i].centroid.x - center.x);
+                    }
+
+                    double step = 2.0 * M_PI / ring.size();
+                    for (size_t i = 1; i < ring.size() && valid; ++i) {
+                        if (std::abs(wrapAngle(phi[i] - phi[i - 1] - step)) * radius > tolerance) valid = false;
+                        // Checked on the vertices: a part with its own symmetry may
+                        // have matched at a different angle
+                        if (!fits(ring[i].slot, ring[0].theta + phi[i] - phi[0])) valid = false;
+                    }
+
+                    if (valid) {
+                        Point3D axis(center.x, center.y, 0.0);
+                        addRun(ring, step, axis - rotateZ(axis, step));
+                        continue;
+                    }
+                }
+            }
+
+            // Otherwise copies sharing an orientation that sit at equal steps
+            std::vector<uint8_t> used(members.size(), 0);
+            for (size_t i = 0; i < members.size(); ++i) {
+                if (used[i]) continue;
+                std::vector<Member> same;
+                for (size_t j = i; j < members.size(); ++j) {
+                    if (!used[j] && std::abs(wrapAngle(members[j].theta - members[i].theta)) * first.size <= tolerance) {
+                        used[j] = 1;
+                        same.push_back(members[j]);
+                    }
+                }
+
+                auto cell = [tolerance](double value) { return std::llround(value / tolerance); };
+                std::sort(same.begin(), same.end(), [&cell](const Member& a, const Member& b) {
+                    if (cell(a.centroid.x) != cell(b.centroid.x)) return cell(a.centroid.x) < cell(b.centroid.x);
+                    if (cell(a.centroid.y) != cell(b.centroid.y)) return cell(a.centroid.y) < cell(b.centroid.y);
+                    return cell(a.centroid.z) < cell(b.centroid.z);
+                });
+
+                for (size_t start = 0; start + 1 < same.size();) {
+                    Point3D step = same[start + 1].centroid - same[start].centroid;
+                    size_t stop = start + 2;
+                    while (stop < same.size() &&
+                           (same[stop].centroid - same[stop - 1].centroid).distance(step) <= tolerance) {
+                        ++stop;
+                    }
+                    addRun(std::vector<Member>(same.begin() + start, same.begin() + stop), 0.0, step);
+                    start = stop;
+                }
+            }
+        }
+    });
+
+    std::vector<uint8_t> covered(componentCount, 0);
+    for (size_t g = 0; g < groups.size(); ++g) {
+        for (auto& run : groupRuns[g]) {
+            result.runs.push_back(std::move(run));
+        }
+        for (uint32_t c : groupCovered[g]) {
+            covered[c] = 1;
+            result.replicatedComponents++;
+        }
+    }
+
+    if (result.runs.empty()) {
+        result.remainder = mesh;
+        return result;
+    }
+
+    std::vector<uint32_t> remaining;
+    remaining.reserve(mesh.faceCount());
+    for (uint32_t f = 0; f < mesh.faceCount(); ++f) {
+        if (componentCount == 0 || !covered[components.faceComponent[f]]) remaining.push_back(f);
+    }
+    result.remainder = MeshTopology::extractFaces(mesh, remaining.data(), remaining.data() + remaining.size());
+
+    return result;
+}
+
+} // namespace stl_to_eznec
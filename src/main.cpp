@@ -1,12 +1,28 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cmath>
+#include <future>
 #include "stl_parser.h"
 #include "material_database.h"
 #include "frequency_calculator.h"
 #include "antenna_detector.h"
 #include "nec_generator.h"
 #include "ez_generator.h"
+#include "deck_writer.h"
+#include "wire_model.h"
+#include "surface_remesher.h"
+#include "mesh_decimator.h"
+#include "mesh_cleaner.h"
+#include "visibility_culler.h"
+#include "waterline_clipper.h"
+#include "thin_shell_collapser.h"
+#include "tube_collapser.h"
+#include "segment_planner.h"
+#include "spacing_field.h"
+#include "surface_patcher.h"
+#include "symmetry_detector.h"
+#include "instance_detector.h"
 #include "user_interface.h"
 
 using namespace stl_to_eznec;
@@ -62,6 +78,9 @@ int main() {
         if (input.frequencyMHz > 0) {
             frequency.setFrequency(input.frequencyMHz);
             frequency.printFrequencyInfo();
+            
+            // Simplify antenna paths relative to the wavelength
+            detector.setPathTolerance(frequency.getPathSimplificationTolerance());
         }
         
         // Detect antenna (if enabled)
@@ -69,9 +88,24 @@ int main() {
         bool hasAntenna = false;
         
         if (input.enableAntennaDetection) {
-            antenna = detector.detectAntenna(triangles);
+            // Rank every wire-like component; the best one becomes the driven antenna
+            std::vector<AntennaWire> antennas = detector.detectAllAntennas(triangles);
+            if (!antennas.empty()) {
+                antenna = antennas.front();
+            }
             ui.printAntennaDetectionResult(antenna);
             
+            if (antennas.size() > 1) {
+                std::cout << "Antenna candidates found: " << antennas.size() << " (using the highest ranked)\n";
+                for (size_t i = 0; i < antennas.size(); ++i) {
+                    std::cout << "  " << (i + 1) << ". " << antennas[i].length << " m long, "
+                              << antennas[i].radius << " m radius, feed at ("
+                              << antennas[i].feedPoint.x << ", " << antennas[i].feedPoint.y << ", "
+                              << antennas[i].feedPoint.z << ")\n";
+                }
+                std::cout << "\n";
+            }
+            
             // Confirm antenna detection
             if (antenna.isDetected) {
                 hasAntenna = ui.getAntennaConfirmation(true);
@@ -84,47 +118,312 @@ int main() {
             hasAntenna = false;
         }
         
-        // Generate NEC file
-        std::cout << "Generating NEC file: " << input.outputNECFilename << "\n";
-        std::string necContent;
-        
-        if (hasAntenna && antenna.isDetected) {
-            necContent = necGen.generateNEC(
-                triangles, input.material, frequency, antenna,
-                input.modelName, true, input.waterlineHeight, input.waterProperties
-            );
+        // Resample the structure into a wire grid sized for the operating frequency;
+        // the driven antenna is written from its centerline, so its facets are left out
+        std::vector<Triangle> structureTriangles;
+        if (hasAntenna && antenna.isDetected && !antenna.component.empty() &&
+            antenna.component.source->components.faceComponent.size() == triangles.size()) {
+            const auto& faceComponent = antenna.component.source->components.faceComponent;
+            structureTriangles.reserve(triangles.size() - antenna.component.size());
+            for (size_t f = 0; f < triangles.size(); ++f) {
+                if (faceComponent[f] != antenna.component.componentId) {
+                    structureTriangles.push_back(triangles[f]);
+                }
+            }
         } else {
-            necContent = necGen.generateNECStructureOnly(triangles, input.material, input.modelName);
+            structureTriangles = triangles;
         }
         
-        // Write NEC file
-        std::ofstream necFile(input.outputNECFilename);
-        if (necFile.is_open()) {
-            necFile << necContent;
-            necFile.close();
-            ui.printSuccess("NEC file generated: " + input.outputNECFilename);
-        } else {
-            ui.printError("Failed to write NEC file: " + input.outputNECFilename);
+        IndexedMesh structureMesh = MeshTopology::buildIndexedMesh(structureTriangles);
+        
+        // Drop degenerate and duplicate facets and parts far below the wavelength
+        CleanupReport cleanup;
+        MeshCleaner cleaner = MeshCleaner::fromFrequency(frequency);
+        structureMesh = cleaner.clean(structureMesh, &cleanup);
+        MeshCleaner::printReport(cleanup);
+        
+        // Below the waterline the water ground plane takes over from the hull.
+        // Only complete decks carry the ground card; a structure-only deck
+        // keeps the whole hull in free space.
+        bool waterGround = hasAntenna && antenna.isDetected && input.waterlineHeight > 0 &&
+                           input.waterProperties != nullptr;
+        double loweredBy = 0.0;
+        if (waterGround) {
+            WaterlineReport waterline;
+            structureMesh = WaterlineClipper(input.waterlineHeight).clip(structureMesh, &waterline);
+            WaterlineClipper::printReport(waterline);
+            
+            // Keep the antenna in the lowered frame
+            for (auto& point : antenna.path) {
+                point.z -= waterline.waterlineZ;
+            }
+            antenna.startPoint.z -= waterline.waterlineZ;
+            antenna.endPoint.z -= waterline.waterlineZ;
+            antenna.feedPoint.z -= waterline.waterlineZ;
+            loweredBy = waterline.waterlineZ;
+        }
+        
+        // Interior parts shielded by the hull carry no external current. The
+        // rays are one grid pitch apart, as planned for the whole mesh: detail
+        // finer than the grid does not change the wires, and the escape pass
+        // still finds small exterior facets the rays pass between.
+        SegmentPlanner planner;
+        size_t antennaSegments = (hasAntenna && antenna.isDetected) ? SegmentPlanner::countPathSegments(antenna.path) : 0;
+        double rayPitch = planner.plan(SegmentPlanner::measure(structureMesh), frequency, antennaSegments).gridSpacing;
+        VisibilityReport visibility;
+        structureMesh = VisibilityCuller(rayPitch).cull(structureMesh, &visibility);
+        VisibilityCuller::printReport(visibility);
+        
+        // A mirror-symmetric structure is built from one half and reflected with GX.
+        // GX would reflect the antenna too, so this only applies without one.
+        SymmetryPlane symmetry;
+        if (!(hasAntenna && antenna.isDetected)) {
+            symmetry = SymmetryDetector().detect(structureMesh);
+        }
+        
+        // From the tubes to the finished grid. A symmetric structure whose
+        // half cannot be gridded goes round again as a whole, from the
+        // culled mesh.
+        IndexedMesh wholeMesh;
+        if (symmetry.found()) {
+            wholeMesh = structureMesh;
+        }
+        SegmentPlan plan;
+        PatchSplit patchSplit;
+        WireGraph structure;
+        WireModel model;
+        for (;;) {
+            // Masts, rails and stays become one centerline wire each
+            TubeCollapser tubeCollapser = TubeCollapser::fromFrequency(frequency);
+            tubeCollapser.setMirrorPlane(symmetry.axis);
+            TubeReport tubeReport;
+            TubeSet tubes = tubeCollapser.collapse(structureMesh, &tubeReport);
+            if (tubeReport.inPlaneTubes > 0) {
+                // A tube lying in the mirror plane has no half to reflect and
+                // would be lost on the seam, so the whole structure is written
+                std::cout << "A tube lies in the mirror plane; writing the whole structure without GX.\n";
+                symmetry = SymmetryPlane();
+                tubeCollapser.setMirrorPlane(-1);
+                tubes = tubeCollapser.collapse(structureMesh, &tubeReport);
+            }
+            structureMesh = std::move(tubes.remainder);
+            TubeCollapser::printReport(tubeReport);
+            
+            // Needle slivers left once the tubes are wires lose their short edge
+            size_t slivers = 0;
+            structureMesh = cleaner.collapseSlivers(structureMesh, &slivers);
+            if (slivers > 0) {
+                std::cout << "Sliver edges collapsed: " << slivers << "\n";
+            }
+            
+            // Plates modelled as two skins would otherwise be meshed twice; after
+            // the tubes, so a box-section mast is not mistaken for two plates
+            ThinShellReport thinShells;
+            structureMesh = ThinShellCollapser::fromFrequency(frequency).collapse(structureMesh, &thinShells);
+            ThinShellCollapser::printReport(thinShells);
+            
+            // Fit grid spacing and decimation to the solver budget before generating anything
+            MeshStatistics statistics = SegmentPlanner::measure(structureMesh);
+            statistics.wireLength = tubes.wires.totalLength();
+            SpacingField spacing;
+            if (hasAntenna && antenna.isDetected && frequency.isValidFrequency() && !antenna.component.empty()) {
+                // Fine grid where currents couple to the antenna, coarser with distance
+                IndexedMesh antennaMesh = MeshTopology::buildIndexedMesh(antenna.getTriangles());
+                for (auto& vertex : antennaMesh.vertices) {
+                    vertex.z -= loweredBy;
+                }
+                spacing = SpacingField::fromFrequency(frequency, antennaMesh);
+                plan = planner.plan(structureMesh, statistics, spacing, antennaSegments);
+            } else {
+                plan = planner.plan(statistics, frequency, antennaSegments);
+                spacing = SpacingField(plan.gridSpacing);
+            }
+            planner.printPlan(plan, frequency);
+            
+            // A half no thicker than one grid pitch clusters onto the seam and
+            // would lose every wire there
+            if (symmetry.found() && !structureMesh.faces.empty() &&
+                plan.gridSpacing >= SymmetryDetector::halfExtent(structureMesh, symmetry)) {
+                std::cout << "The symmetric half is thinner than the grid pitch; writing the whole structure without GX.\n";
+                symmetry = SymmetryPlane();
+                structureMesh = std::move(wholeMesh);
+                continue;
+            }
+            
+            if (symmetry.found()) {
+                structureMesh = SymmetryDetector::keepHalf(structureMesh, symmetry);
+                std::cout << "Structure is symmetric about " << (symmetry.axis == 0 ? "x" : "y") << " = 0 ("
+                          << DeckWriter::fixed(symmetry.matchFraction * 100.0, 1)
+                          << "% of vertices mirrored); generating one half\n";
+            }
+            
+            // Repeated parts are written once and copied with GM cards
+            InstanceDetector instanceDetector;
+            instanceDetector.setMinExtent(plan.gridSpacing);
+            InstanceSet instances = instanceDetector.detect(structureMesh);
+            if (!instances.runs.empty()) {
+                structureMesh = std::move(instances.remainder);
+                std::cout << "Repeated parts: " << instances.replicatedComponents << " components from "
+                          << instances.runs.size() << " prototypes\n";
+            }
+            
+            // Build the grid and the model, then count the real deck: the plan is
+            // an estimate, so an oversized deck is rebuilt at a wider pitch
+            const int MAX_GRID_ATTEMPTS = 4;
+            bool emptyHalf = false;
+            for (int attempt = 1;; ++attempt) {
+                IndexedMesh gridMesh = structureMesh;
+                std::vector<InstanceRun> runs = instances.runs;
+                WireGraph tubeWires = tubes.wires;
+            
+                // Collapse facet detail far below the grid pitch before building wires
+                if (plan.decimationEdgeLength > 0.0) {
+                    size_t facetsBefore = gridMesh.faceCount();
+                    MeshDecimator decimator;
+                    decimator.setMinEdgeLength(plan.decimationEdgeLength);
+                    gridMesh = decimator.decimate(gridMesh);
+                    for (auto& run : runs) {
+                        run.prototype = decimator.decimate(run.prototype);
+                    }
+                    std::cout << "Structure decimated: " << facetsBefore << " -> " << gridMesh.faceCount() << " facets\n";
+                }
+            
+                // Closed bodies become NEC surface patches where that takes fewer unknowns.
+                // NEC-2 has no patches over a Sommerfeld ground, and EZNEC none at all,
+                // so the EZ deck keeps them as wire grids.
+                patchSplit = PatchSplit();
+                if (frequency.isValidFrequency() && !waterGround) {
+                    std::vector<Point3D> attachments = tubeWires.nodes;
+                    if (hasAntenna && antenna.isDetected) {
+                        attachments.insert(attachments.end(), antenna.path.begin(), antenna.path.end());
+                    }
+                    SurfacePatcher patcher = SurfacePatcher::fromFrequency(frequency, plan.gridSpacing);
+                    patcher.setMirrorPlane(symmetry.axis);
+                    PatchReport patchReport;
+                    patchSplit = patcher.split(gridMesh, spacing, attachments, plan.farSpacing / std::sqrt(3.0), &patchReport);
+                    SurfacePatcher::printReport(patchReport);
+                    if (patchReport.patchedComponents > 0) {
+                        gridMesh = std::move(patchSplit.wireMesh);
+                    }
+                }
+            
+                SurfaceRemesher remesher(plan.gridSpacing);
+                remesher.setMirrorPlane(symmetry.axis);
+                remesher.setGroundPlane(waterGround);
+                structure = remesher.remesh(gridMesh, spacing);
+                if (symmetry.found() && structure.empty() && !gridMesh.faces.empty()) {
+                    emptyHalf = true;
+                    break;
+                }
+            
+                // Tube ends within a grid cell's circumradius join the nearest node
+                tubeWires.segmentLength = structure.segmentLength;
+                if (spacing.isGraded()) {
+                    for (const auto& edge : tubeWires.edges) {
+                        tubeWires.edgeSegments.push_back(spacing.segmentCount(tubeWires.nodes[edge[0]],
+                                                                              tubeWires.nodes[edge[1]]));
+                    }
+                }
+                structure.appendWires(tubeWires, plan.farSpacing / std::sqrt(3.0));
+                for (const auto& run : runs) {
+                    structure.appendReplicated(remesher.remesh(run.prototype, spacing), run.copies, run.rotateZDegrees,
+                                               run.translation);
+                }
+                structure = structure.mergeCollinearChains();
+                
+                // An antenna fed at one end is attached there; that end joins
+                // the nearest node within the same reach, or splits the
+                // nearest wire, and the feed moves with it
+                AntennaWire joinedAntenna = antenna;
+                if (hasAntenna && antenna.isDetected && antenna.path.size() >= 2) {
+                    std::vector<Point3D>& path = joinedAntenna.path;
+                    bool fedAtStart = antenna.feedPoint.distance(path.front()) < 1e-9;
+                    bool fedAtEnd = antenna.feedPoint.distance(path.back()) < 1e-9;
+                    Point3D& end = fedAtStart ? path.front() : path.back();
+                    const Point3D& next = fedAtStart ? path[1] : path[path.size() - 2];
+                    
+                    // An end on the water is fed against the ground instead
+                    bool onWater = waterGround && std::abs(end.z) <= AntennaDetector::attachDistance(antenna.radius);
+                    uint32_t node = (fedAtStart || fedAtEnd) && !onWater
+                        ? structure.joinPoint(end, plan.farSpacing / std::sqrt(3.0))
+                        : 0xFFFFFFFFu;
+                    if (node != 0xFFFFFFFFu && structure.nodes[node].distance(next) > antenna.radius) {
+                        end = structure.nodes[node];
+                        joinedAntenna.feedPoint = end;
+                        joinedAntenna.startPoint = path.front();
+                        joinedAntenna.endPoint = path.back();
+                    }
+                }
+                std::cout << "Structure wire grid: " << structure.nodeCount() << " nodes, " << structure.edgeCount()
+                          << " wires\n";
+            
+                // One format-neutral model for both decks
+                model = hasAntenna && antenna.isDetected
+                    ? WireModel::build(structure, input.material, frequency, joinedAntenna, input.modelName, true,
+                                       input.waterlineHeight, input.waterProperties)
+                    : WireModel::buildStructureOnly(structure, input.material, input.modelName);
+                model.gridSpacing = plan.gridSpacing;
+                model.farGridSpacing = plan.farSpacing;
+                if (!patchSplit.patches.faces.empty()) {
+                    model.setSurfacePatches(patchSplit.patches,
+                                            remesher.remesh(patchSplit.patchedMesh, spacing).mergeCollinearChains());
+                }
+            
+                if (planner.checkDeck(plan, model.solverUnknowns()) || attempt == MAX_GRID_ATTEMPTS ||
+                    !planner.widen(plan, spacing)) {
+                    break;
+                }
+                std::cout << "Deck has " << plan.deckSegments << " segments, over the budget; regridding at "
+                          << DeckWriter::fixed(plan.gridSpacing * 100.0, 1) << " cm\n";
+            }
+            
+            // The mirrored grid came out empty; rebuild from the whole structure
+            if (emptyHalf) {
+                std::cout << "The symmetric half has no grid wires; writing the whole structure without GX.\n";
+                symmetry = SymmetryPlane();
+                structureMesh = std::move(wholeMesh);
+                continue;
+            }
+            break;
+        }
+        planner.printDeckCheck(plan);
+        NECDeck::printStatistics(model.wires.statistics());
+        std::cout << "\n";
+
+        // A grid coarser than the bodies can leave nothing to simulate
+        if (model.wires.empty() && model.patches.faces.empty()) {
+            ui.printError("The wire grid is empty; no NEC or EZ file was written.");
+            std::cout << "Try a higher frequency so the grid is finer than the model.\n";
+            return 1;
+        }
+        if (!structureTriangles.empty() && structure.edgeCount() == 0 && patchSplit.patches.faces.empty()) {
+            std::cout << "WARNING: The structure produced no wires; the deck holds the antenna only.\n\n";
         }
         
-        // Generate EZ file
+        // Generate the NEC and EZ files side by side, each streamed card by card
+        std::cout << "Generating NEC file: " << input.outputNECFilename << "\n";
         std::cout << "Generating EZ file: " << input.outputEZFilename << "\n";
-        std::string ezContent;
+        DeckWriter necDeck;
+        DeckWriter ezDeck;
         
-        if (hasAntenna && antenna.isDetected) {
-            ezContent = ezGen.generateEZ(
-                triangles, input.material, frequency, antenna,
-                input.modelName, true, input.waterlineHeight, input.waterProperties
-            );
-        } else {
-            ezContent = ezGen.generateEZStructureOnly(triangles, input.material, input.modelName);
+        // Its own thread rather than a pool task, since both emitters format
+        // their wires on the pool
+        auto ezWritten = std::async(std::launch::async, [&]() {
+            if (ezDeck.open(input.outputEZFilename)) {
+                ezGen.writeEZ(ezDeck, model);
+            }
+            return ezDeck.close();
+        });
+        if (necDeck.open(input.outputNECFilename)) {
+            necGen.writeNEC(necDeck, model);
         }
         
-        // Write EZ file
-        std::ofstream ezFile(input.outputEZFilename);
-        if (ezFile.is_open()) {
-            ezFile << ezContent;
-            ezFile.close();
+        if (necDeck.close()) {
+            ui.printSuccess("NEC file generated: " + input.outputNECFilename);
+        } else {
+            ui.printError("Failed to write NEC file: " + input.outputNECFilename);
+        }
+        if (ezWritten.get()) {
             ui.printSuccess("EZ file generated: " + input.outputEZFilename);
         } else {
             ui.printError("Failed to write EZ file: " + input.outputEZFilename);
@@ -136,10 +435,11 @@ int main() {
         std::cout << "Output: " << input.outputNECFilename << ", " << input.outputEZFilename << "\n";
         std::cout << "Material: " << input.material.name << "\n";
         if (input.frequencyMHz > 0) {
-            std::cout << "Frequency: " << input.frequencyMHz << " MHz\n";
+            std::cout << "Frequency: " << DeckWriter::fixed(input.frequencyMHz, 1) << " MHz\n";
         }
         if (hasAntenna && antenna.isDetected) {
-            std::cout << "Antenna: " << antenna.length << " m length, " << antenna.radius << " m radius\n";
+            std::cout << "Antenna: " << DeckWriter::fixed(antenna.length, 3) << " m length, "
+                      << DeckWriter::fixed(antenna.radius * 1000.0, 2) << " mm radius\n";
         } else {
             std::cout << "Antenna: None detected\n";
         }
@@ -1,5 +1,10 @@
 #include "memory_manager.h"
 #include "antenna_detector.h"
+#include "mesh_topology.h"
+#include "covariance_accumulator.h"
+#include "wire_skeleton.h"
+#include "mesh_bvh.h"
+#include "thread_pool.h"
 #include <iostream>
 #include <fstream>
 #include <sys/resource.h>
@@ -9,6 +14,7 @@
 #include <iomanip>
 #include <algorithm>
 #include <cstdint>
+#include <cmath>
 
 namespace stl_to_eznec {
 
@@ -264,26 +270,168 @@ MemoryEfficientSTLParser::STLFileStats MemoryEfficientSTLParser::getFileStats(co
     return analyzeSTLFile(filename);
 }
 
-AntennaWire MemoryEfficientSTLParser::detectAntennaStreaming(const std::string& filename) {
+AntennaWire MemoryEfficientSTLParser::detectAntennaStreaming(const std::string& filename, double pathTolerance) {
     AntennaWire antenna;
+    AntennaDetector limits; // Default detection parameters
+    limits.setPathTolerance(pathTolerance);
+    const double weldTolerance = 1e-6;
     
-    // Process file in chunks and detect antenna
-    processSTLFile(filename, [&antenna](const std::vector<Triangle>& chunk) {
-        // Simple antenna detection on chunk
-        // This is a simplified version - full implementation would be more complex
+    // Pass 1: weld vertices, join them into components with union-find and keep
+    // one covariance accumulator per component root. Triangles are not retained.
+    SpatialHash vertexHash(weldTolerance);
+    std::vector<uint32_t> parent;
+    std::vector<CovarianceAccumulator> moments;
+    
+    auto findRoot = [&parent](uint32_t node) {
+        while (parent[node] != node) {
+            parent[node] = parent[parent[node]];
+            node = parent[node];
+        }
+        return node;
+    };
+    
+    auto vertexId = [&](const Point3D& point) {
+        int64_t existing = vertexHash.findNear(point, weldTolerance);
+        if (existing >= 0) return static_cast<uint32_t>(existing);
+        uint32_t id = static_cast<uint32_t>(parent.size());
+        vertexHash.insert(point, id);
+        parent.push_back(id);
+        moments.emplace_back();
+        return id;
+    };
+    
+    // Welding is sequential; each chunk's moments are then summed on the pool
+    // in fixed blocks, one partial per run of facets on the same root, and
+    // merged in block order so the result does not depend on the thread count
+    const size_t BLOCK = 16384;
+    struct RootMoments {
+        uint32_t root;
+        CovarianceAccumulator moments;
+    };
+    std::vector<uint32_t> faceRoot;
+    bool processed = processSTLFile(filename, [&](const std::vector<Triangle>& chunk) {
+        faceRoot.resize(chunk.size());
+        for (size_t t = 0; t < chunk.size(); ++t) {
+            const Triangle& triangle = chunk[t];
+            uint32_t root = findRoot(vertexId(triangle.vertices[0]));
+            for (int i = 1; i < 3; ++i) {
+                uint32_t other = findRoot(vertexId(triangle.vertices[i]));
+                if (other != root) {
+                    // Union: the surviving root absorbs the other component's moments
+                    if (other < root) std::swap(root, other);
+                    parent[other] = root;
+                    moments[root].merge(moments[other]);
+                    moments[other] = CovarianceAccumulator();
+                }
+            }
+            faceRoot[t] = root;
+        }
+        
+        // Roots stay put until the next chunk's unions
+        for (auto& root : faceRoot) {
+            root = findRoot(root);
+        }
+        size_t blockCount = (chunk.size() + BLOCK - 1) / BLOCK;
+        std::vector<std::vector<RootMoments>> partial(blockCount);
+        ThreadPool::getInstance().parallelFor(blockCount, [&](size_t begin, size_t end) {
+            for (size_t block = begin; block < end; ++block) {
+                std::vector<RootMoments>& runs = partial[block];
+                size_t last = std::min(chunk.size(), (block + 1) * BLOCK);
+                for (size_t t = block * BLOCK; t < last; ++t) {
+                    if (runs.empty() || runs.back().root != faceRoot[t]) {
+                        runs.push_back({faceRoot[t], CovarianceAccumulator()});
+                    }
+                    runs.back().moments.addTriangle(chunk[t]);
+                }
+            }
+        });
+        for (const auto& runs : partial) {
+            for (const auto& run : runs) {
+                moments[run.root].merge(run.moments);
+            }
+        }
+    });
+    
+    if (!processed) return antenna;
+    
+    // Classify every component from its moments alone and keep the most
+    // slender one, ranked by length / radius as detectAllAntennas does; the
+    // lowest root wins ties
+    int64_t antennaRoot = -1;
+    double bestScore = 0.0;
+    for (uint32_t v = 0; v < parent.size(); ++v) {
+        if (parent[v] != v || moments[v].isEmpty()) continue;
+        
+        OrientedExtents extents = moments[v].getOrientedExtents();
+        if (extents.crossSectionDiameter > 0.0 &&
+            extents.crossSectionDiameter <= limits.getMaxWireDiameter() &&
+            extents.length >= limits.getMinWireLength() &&
+            extents.length <= limits.getMaxWireLength()) {
+            double score = extents.length / (0.5 * extents.crossSectionDiameter);
+            if (score > bestScore) {
+                bestScore = score;
+                antennaRoot = v;
+            }
+        }
+    }
+    
+    if (antennaRoot < 0) return antenna;
+    
+    auto inAntenna = [&](const Triangle& triangle) {
+        int64_t id = vertexHash.findNear(triangle.vertices[0], weldTolerance);
+        return id >= 0 && findRoot(static_cast<uint32_t>(id)) == antennaRoot;
+    };
+    
+    // Pass 2: collect only the facets of the selected component
+    std::vector<Triangle> wireTriangles;
+    processSTLFile(filename, [&](const std::vector<Triangle>& chunk) {
         for (const auto& triangle : chunk) {
-            if (GeometryUtils::isWireLike({triangle})) {
-                antenna.triangles.push_back(triangle);
+            if (inAntenna(triangle)) {
+                wireTriangles.push_back(triangle);
             }
         }
     });
     
     // Analyze detected antenna
-    if (!antenna.triangles.empty()) {
-        antenna.path = GeometryUtils::extractWirePathAdvanced(antenna.triangles);
+    if (!wireTriangles.empty()) {
+        antenna.component = ComponentView(MeshTopology::buildComponentMesh(wireTriangles), 0);
+        WireCenterline centerline = WireSkeleton::extractCenterline(antenna.component);
+        antenna.path = GeometryUtils::simplifyWirePath(centerline.path, limits.getPathTolerance());
         antenna.length = GeometryUtils::calculateWireLength(antenna.path);
-        antenna.radius = GeometryUtils::calculateWireRadius(antenna.triangles);
+        antenna.radius = centerline.radius;
+        antenna.score = antenna.radius > 0.0 ? antenna.length / antenna.radius : 0.0;
         antenna.isDetected = true;
+        
+        if (!antenna.path.empty()) {
+            antenna.startPoint = antenna.path.front();
+            antenna.endPoint = antenna.path.back();
+            
+            // Pass 3: the other facets within reach of either end decide
+            // where the feed goes, as AntennaDetector places it
+            double reach = AntennaDetector::attachDistance(antenna.radius);
+            auto nearPoint = [reach](const Triangle& triangle, const Point3D& point) {
+                Point3D centre = (triangle.vertices[0] + triangle.vertices[1] + triangle.vertices[2]) * (1.0 / 3.0);
+                double bound = std::max(centre.distance(triangle.vertices[0]),
+                                        std::max(centre.distance(triangle.vertices[1]), centre.distance(triangle.vertices[2])));
+                return centre.distance(point) <= bound + reach;
+            };
+            std::vector<Triangle> nearEnds;
+            processSTLFile(filename, [&](const std::vector<Triangle>& chunk) {
+                for (const auto& triangle : chunk) {
+                    if ((nearPoint(triangle, antenna.startPoint) || nearPoint(triangle, antenna.endPoint)) &&
+                        !inAntenna(triangle)) {
+                        nearEnds.push_back(triangle);
+                    }
+                }
+            });
+            IndexedMesh nearMesh = MeshTopology::buildIndexedMesh(nearEnds);
+            MeshBVH bvh(nearMesh);
+            auto attached = [&](const Point3D& point) {
+                return std::fabs(point.z) <= reach || bvh.nearest(point, reach).found();
+            };
+            antenna.feedPoint = limits.chooseFeedPoint(antenna.path, attached(antenna.startPoint),
+                                                       attached(antenna.endPoint));
+        }
     }
     
     return antenna;
@@ -0,0 +1,353 @@
+#include "mesh_bvh.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace stl_to_eznec {
+
+namespace {
+
+Point3D cross(const Point3D& a, const Point3D& b) {
+    return Point3D(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+double dot(const Point3D& a, const Point3D& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+double axisValue(const Point3D& p, int axis) {
+    return axis == 0 ? p.x : (axis == 1 ? p.y : p.z);
+}
+
+// Entry distance of the ray into the box, or infinity if it misses within maxDistance
+double slabEntry(const Point3D& low, const Point3D& high, const Point3D& origin, const Point3D& inverse,
+                 double maxDistance) {
+    double near = 0.0;
+    double far = maxDistance;
+    for (int axis = 0; axis < 3; ++axis) {
+        double o = axisValue(origin, axis);
+        double inv = axisValue(inverse, axis);
+        double t0 = (axisValue(low, axis) - o) * inv;
+        double t1 = (axisValue(high, axis) - o) * inv;
+        if (t0 > t1) std::swap(t0, t1);
+        // NaN from 0 * inf (ray in a slab plane) leaves the bounds unchanged
+        if (t0 > near) near = t0;
+        if (t1 < far) far = t1;
+        if (near > far) return std::numeric_limits<double>::infinity();
+    }
+    return near;
+}
+
+// Squared distance from p to the box, 0 inside
+double boxDistanceSquared(const Point3D& low, const Point3D& high, const Point3D& p) {
+    double total = 0.0;
+    for (int axis = 0; axis < 3; ++axis) {
+        double v = axisValue(p, axis);
+        double d = std::max(std::max(axisValue(low, axis) - v, 0.0), v - axisValue(high, axis));
+        total += d * d;
+    }
+    return total;
+}
+
+// Closest point to p on triangle abc (Ericson, Real-Time Collision Detection 5.1.5)
+Point3D closestOnTriangle(const Point3D& p, const Point3D& a, const Point3D& b, const Point3D& c) {
+    Point3D ab = b - a, ac = c - a, ap = p - a;
+    double d1 = dot(ab, ap), d2 = dot(ac, ap);
+    if (d1 <= 0.0 && d2 <= 0.0) return a;
+
+    Point3D bp = p - b;
+    double d3 = dot(ab, bp), d4 = dot(ac, bp);
+    if (d3 >= 0.0 && d4 <= d3) return b;
+
+    double vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) return a + ab * (d1 / (d1 - d3));
+
+    Point3D cp = p - c;
+    double d5 = dot(ab, cp), d6 = dot(ac, cp);
+    if (d6 >= 0.0 && d5 <= d6) return c;
+
+    double vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) return a + ac * (d2 / (d2 - d6));
+
+    double va = d3 * d6 - d5 * d4;
+    if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0) {
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    }
+
+    double denominator = va + vb + vc;
+    if (denominator == 0.0) return a;
+    double v = vb / denominator;
+    double w = vc / denominator;
+    return a + ab * v + ac * w;
+}
+
+} // namespace
+
+MeshBVH::MeshBVH(const IndexedMesh& mesh) : mesh_(&mesh) {
+    if (mesh.faces.empty()) return;
+
+    std::vector<Point3D> centroids(mesh.faceCount());
+    faces_.resize(mesh.faceCount());
+    for (uint32_t f = 0; f < mesh.faceCount(); ++f) {
+        const auto& face = mesh.faces[f];
+        centroids[f] = (mesh.vertices[face[0]] + mesh.vertices[face[1]] + mesh.vertices[face[2]]) * (1.0 / 3.0);
+        faces_[f] = f;
+    }
+
+    nodes_.reserve(2 * mesh.faceCount() / LEAF_SIZE + 1);
+    build(centroids, 0, static_cast<uint32_t>(mesh.faceCount()));
+}
+
+uint32_t MeshBVH::build(std::vector<Point3D>& centroids, uint32_t begin, uint32_t end) {
+    uint32_t index = static_cast<uint32_t>(nodes_.size());
+    nodes_.push_back(Node());
+
+    const IndexedMesh& mesh = *mesh_;
+    Point3D low = mesh.vertices[mesh.faces[faces_[begin]][0]];
+    Point3D high = low;
+    Point3D centroidLow = centroids[faces_[begin]];
+    Point3D centroidHigh = centroidLow;
+    for (uint32_t i = begin; i < end; ++i) {
+        for (uint32_t v : mesh.faces[faces_[i]]) {
+            const Point3D& p = mesh.vertices[v];
+            low = Point3D(std::min(low.x, p.x), std::min(low.y, p.y), std::min(low.z, p.z));
+            high = Point3D(std::max(high.x, p.x), std::max(high.y, p.y), std::max(high.z, p.z));
+        }
+        const Point3D& c = centroids[faces_[i]];
+        centroidLow = Point3D(std::min(centroidLow.x, c.x), std::min(centroidLow.y, c.y), std::min(centroidLow.z, c.z));
+        centroidHigh = Point3D(std::max(centroidHigh.x, c.x), std::max(centroidHigh.y, c.y), std::max(centroidHigh.z, c.z));
+    }
+    nodes_[index].low = low;
+    nodes_[index].high = high;
+
+    Point3D span = centroidHigh - centroidLow;
+    if (end - begin <= LEAF_SIZE || std::max(span.x, std::max(span.y, span.z)) <= 0.0) {
+        nodes_[index].first = begin;
+        nodes_[index].count = end - begin;
+        return index;
+    }
+
+    // Binned surface-area heuristic: pick the bin boundary that minimises
+    // the summed (box area x facet count) of the two children
+    const int BINS = 16;
+    double bestCost = std::numeric_limits<double>::infinity();
+    int bestAxis = -1;
+    int bestSplit = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+        double extent = axisValue(span, axis);
+        if (extent <= 0.0) continue;
+        double origin = axisValue(centroidLow, axis);
+        double scale = BINS / extent;
+
+        const double infinity = std::numeric_limits<double>::infinity();
+        uint32_t counts[BINS] = {};
+        Point3D binLow[BINS], binHigh[BINS];
+        for (int b = 0; b < BINS; ++b) {
+            binLow[b] = Point3D(infinity, infinity, infinity);
+            binHigh[b] = Point3D(-infinity, -infinity, -infinity);
+        }
+        for (uint32_t i = begin; i < end; ++i) {
+            int bin = std::min(BINS - 1, static_cast<int>((axisValue(centroids[faces_[i]], axis) - origin) * scale));
+            counts[bin]++;
+            for (uint32_t v : mesh.faces[faces_[i]]) {
+                const Point3D& p = mesh.vertices[v];
+                binLow[bin] = Point3D(std::min(binLow[bin].x, p.x), std::min(binLow[bin].y, p.y), std::min(binLow[bin].z, p.z));
+                binHigh[bin] = Point3D(std::max(binHigh[bin].x, p.x), std::max(binHigh[bin].y, p.y), std::max(binHigh[bin].z, p.z));
+            }
+        }
+
+        // Sweep from the right to get suffix areas, then from the left
+        auto halfArea = [](const Point3D& low, const Point3D& high) {
+            Point3D d = high - low;
+            return d.x * d.y + d.y * d.z + d.z * d.x;
+        };
+        auto grow = [](Point3D& low, Point3D& high, const Point3D& otherLow, const Point3D& otherHigh) {
+            low = Point3D(std::min(low.x, otherLow.x), std::min(low.y, otherLow.y), std::min(low.z, otherLow.z));
+            high = Point3D(std::max(high.x, otherHigh.x), std::max(high.y, otherHigh.y), std::max(high.z, otherHigh.z));
+        };
+
+        double rightArea[BINS];
+        uint32_t rightCount[BINS];
+        Point3D low(infinity, infinity, infinity), high(-infinity, -infinity, -infinity);
+        uint32_t count = 0;
+        for (int b = BINS - 1; b > 0; --b) {
+            grow(low, high, binLow[b], binHigh[b]);
+            count += counts[b];
+            rightArea[b] = count > 0 ? halfArea(low, high) : 0.0;
+            rightCount[b] = count;
+        }
+        low = Point3D(infinity, infinity, infinity);
+        high = Point3D(-infinity, -infinity, -infinity);
+        count = 0;
+        for (int b = 0; b < BINS - 1; ++b) {
+            grow(low, high, binLow[b], binHigh[b]);
+            count += counts[b];
+            if (count == 0 || rightCount[b + 1] == 0) continue;
+            double cost = halfArea(low, high) * count + rightArea[b + 1] * rightCount[b + 1];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b + 1;
+            }
+        }
+    }
+
+    uint32_t middle = begin + (end - begin) / 2;
+    if (bestAxis >= 0) {
+        double origin = axisValue(centroidLow, bestAxis);
+        double scale = BINS / axisValue(span, bestAxis);
+        auto split = std::partition(faces_.begin() + begin, faces_.begin() + end,
+                                    [&](uint32_t f) {
+                                        int bin = std::min(BINS - 1, static_cast<int>((axisValue(centroids[f], bestAxis) - origin) * scale));
+                                        return bin < bestSplit;
+                                    });
+        middle = static_cast<uint32_t>(split - faces_.begin());
+    }
+    if (middle == begin || middle == end) {
+        // All centroids in one bin: fall back to a median split
+        int axis = span.x >= span.y && span.x >= span.z ? 0 : (span.y >= span.z ? 1 : 2);
+        middle = begin + (end - begin) / 2;
+        std::nth_element(faces_.begin() + begin, faces_.begin() + middle, faces_.begin() + end,
+                         [&centroids, axis](uint32_t a, uint32_t b) {
+                             return axisValue(centroids[a], axis) < axisValue(centroids[b], axis);
+                         });
+    }
+
+    build(centroids, begin, middle);
+    uint32_t right = build(centroids, middle, end);
+    nodes_[index].first = right;
+    nodes_[index].count = 0;
+    return index;
+}
+
+BVHHit MeshBVH::intersect(const Point3D& origin, const Point3D& direction, double maxDistance,
+                          int64_t ignoreFace) const {
+    return traverse(origin, direction, maxDistance, ignoreFace, false);
+}
+
+bool MeshBVH::occluded(const Point3D& origin, const Point3D& direction, double maxDistance,
+                       int64_t ignoreFace) const {
+    return traverse(origin, direction, maxDistance, ignoreFace, true).found();
+}
+
+BVHHit MeshBVH::nearest(const Point3D& point, double maxDistance) const {
+    BVHHit hit;
+    if (nodes_.empty()) return hit;
+
+    double closest = maxDistance * maxDistance;
+    if (boxDistanceSquared(nodes_[0].low, nodes_[0].high, point) > closest) return hit;
+
+    uint32_t stack[64];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        uint32_t index = stack[--top];
+        const Node& node = nodes_[index];
+        if (boxDistanceSquared(node.low, node.high, point) > closest) continue;
+
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                const auto& face = mesh_->faces[faces_[i]];
+                Point3D q = closestOnTriangle(point, mesh_->vertices[face[0]], mesh_->vertices[face[1]],
+                                              mesh_->vertices[face[2]]);
+                Point3D d = q - point;
+                double distanceSquared = dot(d, d);
+                if (distanceSquared <= closest) {
+                    closest = distanceSquared;
+                    hit.face = faces_[i];
+                    hit.point = q;
+                }
+            }
+            continue;
+        }
+
+        // Nearer child on top of the stack
+        uint32_t left = index + 1;
+        uint32_t right = node.first;
+        double leftDistance = boxDistanceSquared(nodes_[left].low, nodes_[left].high, point);
+        double rightDistance = boxDistanceSquared(nodes_[right].low, nodes_[right].high, point);
+        if (leftDistance > rightDistance) {
+            std::swap(left, right);
+            std::swap(leftDistance, rightDistance);
+        }
+        if (rightDistance <= closest && top < 64) stack[top++] = right;
+        if (leftDistance <= closest && top < 64) stack[top++] = left;
+    }
+
+    if (hit.found()) {
+        hit.distance = std::sqrt(closest);
+    }
+    return hit;
+}
+
+BVHHit MeshBVH::traverse(const Point3D& origin, const Point3D& direction, double maxDistance,
+                         int64_t ignoreFace, bool anyHit) const {
+    BVHHit hit;
+    if (nodes_.empty()) return hit;
+
+    const double infinity = std::numeric_limits<double>::infinity();
+    Point3D inverse(direction.x != 0.0 ? 1.0 / direction.x : infinity,
+                    direction.y != 0.0 ? 1.0 / direction.y : infinity,
+                    direction.z != 0.0 ? 1.0 / direction.z : infinity);
+    double closest = maxDistance;
+
+    uint32_t stack[64];
+    int top = 0;
+    if (slabEntry(nodes_[0].low, nodes_[0].high, origin, inverse, closest) == infinity) return hit;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const Node& node = nodes_[stack[--top]];
+
+        if (node.count > 0) {
+            // Moller-Trumbore against every facet in the leaf
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                uint32_t f = faces_[i];
+                if (static_cast<int64_t>(f) == ignoreFace) continue;
+                const auto& face = mesh_->faces[f];
+                const Point3D& a = mesh_->vertices[face[0]];
+                Point3D e1 = mesh_->vertices[face[1]] - a;
+                Point3D e2 = mesh_->vertices[face[2]] - a;
+                Point3D p = cross(direction, e2);
+                double determinant = dot(e1, p);
+                if (std::abs(determinant) < 1e-300) continue;
+                double inv = 1.0 / determinant;
+                Point3D s = origin - a;
+                double u = dot(s, p) * inv;
+                if (u < 0.0 || u > 1.0) continue;
+                Point3D q = cross(s, e1);
+                double v = dot(direction, q) * inv;
+                if (v < 0.0 || u + v > 1.0) continue;
+                double t = dot(e2, q) * inv;
+                if (t > 0.0 && t < closest) {
+                    closest = t;
+                    hit.face = f;
+                    hit.distance = t;
+                    if (anyHit) break;
+                }
+            }
+            if (anyHit && hit.found()) break;
+            continue;
+        }
+
+        // Visit the nearer child first so hits shrink the search early
+        uint32_t left = static_cast<uint32_t>(&node - nodes_.data()) + 1;
+        uint32_t right = node.first;
+        double leftEntry = slabEntry(nodes_[left].low, nodes_[left].high, origin, inverse, closest);
+        double rightEntry = slabEntry(nodes_[right].low, nodes_[right].high, origin, inverse, closest);
+        if (leftEntry > rightEntry) {
+            std::swap(left, right);
+            std::swap(leftEntry, rightEntry);
+        }
+        if (rightEntry != infinity && top < 64) stack[top++] = right;
+        if (leftEntry != infinity && top < 64) stack[top++] = left;
+    }
+
+    if (hit.found()) {
+        hit.point = origin + direction * hit.distance;
+    }
+    return hit;
+}
+
+} // namespace stl_to_eznec
@@ -0,0 +1,191 @@
+#include "mesh_cleaner.h"
+#include "covariance_accumulator.h"
+#include "thread_pool.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+namespace stl_to_eznec {
+
+MeshCleaner::MeshCleaner(double minFeatureSize)
+    : minFeatureSize_(minFeatureSize), sliverRatio_(1e-4) {
+}
+
+MeshCleaner MeshCleaner::fromFrequency(const FrequencyCalculator& frequency, double divisions) {
+    if (!frequency.isValidFrequency() || divisions <= 0.0) {
+        return MeshCleaner();
+    }
+    return MeshCleaner(frequency.getWavelength() / divisions);
+}
+
+IndexedMesh MeshCleaner::clean(const IndexedMesh& mesh, CleanupReport* report) const {
+    CleanupReport local;
+    CleanupReport& result = report ? *report : local;
+    result = CleanupReport();
+    result.inputFacets = mesh.faceCount();
+
+    // Degenerate facets: welded to a line or point, or of zero area to
+    // rounding. Slivers are real geometry (a thin mast faceted with
+    // full-length triangles is nothing else) and stay.
+    const double ZERO_AREA = 1e-12;
+    std::vector<uint8_t> keep(mesh.faceCount(), 1);
+    ThreadPool::getInstance().parallelFor(mesh.faceCount(), [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            const auto& face = mesh.faces[f];
+            if (face[0] == face[1] || face[1] == face[2] || face[0] == face[2]) {
+                keep[f] = 0;
+                continue;
+            }
+            double longest = 0.0;
+            for (int i = 0; i < 3; ++i) {
+                longest = std::max(longest, mesh.vertices[face[i]].distance(mesh.vertices[face[(i + 1) % 3]]));
+            }
+            // Height over the longest edge is 2A / L^2
+            double area = mesh.triangle(f).area();
+            if (longest <= 0.0 || 2.0 * area <= ZERO_AREA * longest * longest) {
+                keep[f] = 0;
+            }
+        }
+    }, 4096);
+
+    // Duplicates share a sorted vertex triple regardless of winding; the first is kept
+    struct FaceKey {
+        std::array<uint32_t, 3> vertices;
+        uint32_t face;
+    };
+    std::vector<FaceKey> keys;
+    keys.reserve(mesh.faceCount());
+    for (uint32_t f = 0; f < mesh.faceCount(); ++f) {
+        if (!keep[f]) {
+            result.degenerateFacets++;
+            continue;
+        }
+        std::array<uint32_t, 3> sorted = mesh.faces[f];
+        std::sort(sorted.begin(), sorted.end());
+        keys.push_back({sorted, f});
+    }
+    std::sort(keys.begin(), keys.end(), [](const FaceKey& a, const FaceKey& b) {
+        return a.vertices != b.vertices ? a.vertices < b.vertices : a.face < b.face;
+    });
+    for (size_t i = 1; i < keys.size(); ++i) {
+        if (keys[i].vertices == keys[i - 1].vertices) {
+            keep[keys[i].face] = 0;
+            result.duplicateFacets++;
+        }
+    }
+
+    std::vector<uint32_t> kept;
+    kept.reserve(keys.size());
+    for (uint32_t f = 0; f < mesh.faceCount(); ++f) {
+        if (keep[f]) kept.push_back(f);
+    }
+    IndexedMesh cleaned = MeshTopology::extractFaces(mesh, kept.data(), kept.data() + kept.size());
+
+    // Components whose largest oriented extent is below the feature size
+    if (minFeatureSize_ > 0.0 && !cleaned.faces.empty()) {
+        ComponentTable components = MeshTopology::findConnectedComponents(cleaned);
+        std::vector<uint8_t> small(components.size(), 0);
+        ThreadPool::getInstance().parallelFor(components.size(), [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; ++c) {
+                CovarianceAccumulator moments;
+                for (uint32_t i = components.offsets[c]; i < components.offsets[c + 1]; ++i) {
+                    const auto& face = cleaned.faces[components.faces[i]];
+                    moments.addTriangle(cleaned.vertices[face[0]], cleaned.vertices[face[1]], cleaned.vertices[face[2]]);
+                }
+                OrientedExtents extents = moments.getOrientedExtents();
+                double largest = std::max(extents.extents[0], std::max(extents.extents[1], extents.extents[2]));
+                small[c] = largest < minFeatureSize_;
+            }
+        });
+
+        // Never cull the whole structure
+        size_t smallFacets = 0;
+        for (size_t c = 0; c < components.size(); ++c) {
+            if (small[c]) {
+                result.smallComponents++;
+                smallFacets += components.faceCount(c);
+            }
+        }
+        if (result.smallComponents > 0 && smallFacets < cleaned.faceCount()) {
+            result.smallComponentFacets = smallFacets;
+            kept.clear();
+            for (uint32_t f = 0; f < cleaned.faceCount(); ++f) {
+                if (!small[components.faceComponent[f]]) kept.push_back(f);
+            }
+            cleaned = MeshTopology::extractFaces(cleaned, kept.data(), kept.data() + kept.size());
+        } else {
+            result.smallComponents = 0;
+        }
+    }
+
+    result.outputFacets = cleaned.faceCount();
+    return cleaned;
+}
+
+IndexedMesh MeshCleaner::collapseSlivers(const IndexedMesh& mesh, size_t* collapsed) const {
+    if (collapsed) *collapsed = 0;
+    if (sliverRatio_ <= 0.0) return mesh;
+
+    // Shortest edge of every needle, as its first vertex index; -1 = none
+    std::vector<int8_t> shortEdge(mesh.faceCount(), -1);
+    double needleRatio = std::sqrt(sliverRatio_);
+    ThreadPool::getInstance().parallelFor(mesh.faceCount(), [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            const auto& face = mesh.faces[f];
+            double lengths[3];
+            for (int i = 0; i < 3; ++i) {
+                lengths[i] = mesh.vertices[face[i]].distance(mesh.vertices[face[(i + 1) % 3]]);
+            }
+            int shortest = static_cast<int>(std::min_element(lengths, lengths + 3) - lengths);
+            double longest = std::max(lengths[0], std::max(lengths[1], lengths[2]));
+            if (longest <= 0.0 || lengths[shortest] > needleRatio * longest) continue;
+            if (2.0 * mesh.triangle(f).area() <= sliverRatio_ * longest * longest) {
+                shortEdge[f] = static_cast<int8_t>(shortest);
+            }
+        }
+    }, 4096);
+
+    // Each vertex moves at most once, so chains of needles cannot drag a
+    // vertex further than one short edge
+    IndexedMesh result = mesh;
+    std::vector<uint32_t> target(mesh.vertexCount());
+    for (uint32_t v = 0; v < target.size(); ++v) {
+        target[v] = v;
+    }
+    std::vector<uint8_t> moved(mesh.vertexCount(), 0);
+    size_t count = 0;
+    for (size_t f = 0; f < mesh.faceCount(); ++f) {
+        if (shortEdge[f] < 0) continue;
+        uint32_t a = mesh.faces[f][shortEdge[f]];
+        uint32_t b = mesh.faces[f][(shortEdge[f] + 1) % 3];
+        if (moved[a] || moved[b]) continue;
+        result.vertices[a] = (mesh.vertices[a] + mesh.vertices[b]) * 0.5;
+        target[b] = a;
+        moved[a] = moved[b] = 1;
+        count++;
+    }
+    if (collapsed) *collapsed = count;
+    if (count == 0) return mesh;
+
+    std::vector<uint32_t> kept;
+    kept.reserve(mesh.faceCount());
+    for (uint32_t f = 0; f < result.faceCount(); ++f) {
+        auto& face = result.faces[f];
+        for (auto& v : face) {
+            v = target[v];
+        }
+        if (face[0] != face[1] && face[1] != face[2] && face[0] != face[2]) kept.push_back(f);
+    }
+    return MeshTopology::extractFaces(result, kept.data(), kept.data() + kept.size());
+}
+
+void MeshCleaner::printReport(const CleanupReport& report) {
+    std::cout << "\n=== Mesh Cleanup ===\n";
+    std::cout << "Degenerate facets removed: " << report.degenerateFacets << "\n";
+    std::cout << "Duplicate facets removed: " << report.duplicateFacets << "\n";
+    std::cout << "Small components removed: " << report.smallComponents << " (" << report.smallComponentFacets
+              << " facets)\n";
+    std::cout << "Facets: " << report.inputFacets << " -> " << report.outputFacets << "\n";
+}
+
+} // namespace stl_to_eznec
@@ -0,0 +1,422 @@
+#include "mesh_decimator.h"
+#include "surface_remesher.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <queue>
+
+namespace stl_to_eznec {
+
+Quadric Quadric::fromPlane(const Point3D& n, const Point3D& point, double weight) {
+    double d = -(n.x * point.x + n.y * point.y + n.z * point.z);
+    Quadric result;
+    result.q = {n.x * n.x, n.x * n.y, n.x * n.z, n.x * d,
+                n.y * n.y, n.y * n.z, n.y * d,
+                n.z * n.z, n.z * d,
+                d * d};
+    for (auto& value : result.q) {
+        value *= weight;
+    }
+    return result;
+}
+
+Quadric& Quadric::operator+=(const Quadric& other) {
+    for (size_t i = 0; i < q.size(); ++i) {
+        q[i] += other.q[i];
+    }
+    return *this;
+}
+
+double Quadric::evaluate(const Point3D& p) const {
+    return q[0] * p.x * p.x + 2 * q[1] * p.x * p.y + 2 * q[2] * p.x * p.z + 2 * q[3] * p.x
+         + q[4] * p.y * p.y + 2 * q[5] * p.y * p.z + 2 * q[6] * p.y
+         + q[7] * p.z * p.z + 2 * q[8] * p.z
+         + q[9];
+}
+
+bool Quadric::minimize(Point3D& point) const {
+    // Solve A x = -b by Cramer's rule
+    double a00 = q[0], a01 = q[1], a02 = q[2];
+    double a11 = q[4], a12 = q[5], a22 = q[7];
+    double c0 = a11 * a22 - a12 * a12;
+    double c1 = a02 * a12 - a01 * a22;
+    double c2 = a01 * a12 - a02 * a11;
+    double det = a00 * c0 + a01 * c1 + a02 * c2;
+
+    double scale = a00 + a11 + a22;
+    if (scale <= 0.0 || std::fabs(det) <= 1e-9 * scale * scale * scale) return false;
+
+    double b0 = -q[3], b1 = -q[6], b2 = -q[8];
+    point.x = (b0 * c0 + b1 * c1 + b2 * c2) / det;
+    point.y = (b0 * c1 + b1 * (a00 * a22 - a02 * a02) + b2 * (a01 * a02 - a00 * a12)) / det;
+    point.z = (b0 * c2 + b1 * (a01 * a02 - a00 * a12) + b2 * (a00 * a11 - a01 * a01)) / det;
+    return true;
+}
+
+namespace {
+
+constexpr int32_t BORDER = -1;
+
+struct Candidate {
+    double cost;
+    uint32_t keep;
+    uint32_t remove;
+    uint32_t keepVersion;
+    uint32_t removeVersion;
+    Point3D position;
+
+    bool operator>(const Candidate& other) const {
+        if (cost != other.cost) return cost > other.cost;
+        if (keep != other.keep) return keep > other.keep;
+        return remove > other.remove;
+    }
+};
+
+using CandidateQueue = std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>>;
+
+Point3D faceNormal(const Point3D& a, const Point3D& b, const Point3D& c) {
+    Point3D e1 = b - a;
+    Point3D e2 = c - a;
+    return Point3D(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+}
+
+double dot(const Point3D& a, const Point3D& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// Mutable mesh with vertex-face adjacency. Slab passes only touch faces whose
+// vertices all lie in their own slab, so they can share one state safely.
+struct CollapseState {
+    IndexedMesh mesh;
+    std::vector<std::vector<uint32_t>> vertexFaces;
+    std::vector<Quadric> quadrics;
+    std::vector<uint8_t> pinned;
+    std::vector<uint8_t> vertexAlive;
+    std::vector<uint8_t> faceAlive;
+    std::vector<uint32_t> version;
+    std::vector<int32_t> slab;   // Slab of each vertex, BORDER if it touches another slab
+    double minEdgeSquared;
+
+    bool eligible(uint32_t v, int32_t partition) const {
+        return vertexAlive[v] && (partition == BORDER || slab[v] == partition);
+    }
+
+    std::vector<uint32_t> neighbours(uint32_t v) const {
+        std::vector<uint32_t> result;
+        for (uint32_t f : vertexFaces[v]) {
+            for (uint32_t w : mesh.faces[f]) {
+                if (w != v) result.push_back(w);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+    bool evaluate(uint32_t u, uint32_t v, Candidate& candidate) const {
+        if (pinned[u] && pinned[v]) return false;
+
+        const Point3D& pu = mesh.vertices[u];
+        const Point3D& pv = mesh.vertices[v];
+        Point3D d = pv - pu;
+        double lengthSquared = dot(d, d);
+        if (minEdgeSquared > 0.0 && lengthSquared >= minEdgeSquared) return false;
+
+        // A pinned vertex never moves; the free one collapses onto it
+        if (pinned[v]) std::swap(u, v);
+
+        Quadric sum = quadrics[u];
+        sum += quadrics[v];
+
+        Point3D position = mesh.vertices[u];
+        if (!pinned[u]) {
+            Point3D midpoint = (mesh.vertices[u] + mesh.vertices[v]) * 0.5;
+            Point3D optimum;
+            // Reject solutions that wander off an ill-conditioned quadric
+            if (sum.minimize(optimum) && dot(optimum - midpoint, optimum - midpoint) <= lengthSquared) {
+                position = optimum;
+            } else {
+                position = midpoint;
+                for (const Point3D* option : {&mesh.vertices[u], &mesh.vertices[v]}) {
+                    if (sum.evaluate(*option) < sum.evaluate(position)) position = *option;
+                }
+            }
+        }
+
+        candidate.cost = std::max(0.0, sum.evaluate(position));
+        candidate.keep = u;
+        candidate.remove = v;
+        candidate.keepVersion = version[u];
+        candidate.removeVersion = version[v];
+        candidate.position = position;
+        return true;
+    }
+
+    bool canCollapse(const Candidate& c) const {
+        // Link condition: the only shared neighbours are the apexes of the
+        // faces on the edge, otherwise the collapse pinches the surface
+        size_t sharedFaces = 0;
+        for (uint32_t f : vertexFaces[c.remove]) {
+            const auto& face = mesh.faces[f];
+            if (face[0] == c.keep || face[1] == c.keep || face[2] == c.keep) sharedFaces++;
+        }
+        if (sharedFaces == 0) return false;
+
+        std::vector<uint32_t> a = neighbours(c.keep);
+        std::vector<uint32_t> b = neighbours(c.remove);
+        std::vector<uint32_t> common;
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(common));
+        if (common.size() != sharedFaces) return false;
+
+        // No surviving face may flip or collapse to zero area
+        for (uint32_t moved : {c.keep, c.remove}) {
+            for (uint32_t f : vertexFaces[moved]) {
+                const auto& face = mesh.faces[f];
+                bool hasKeep = face[0] == c.keep || face[1] == c.keep || face[2] == c.keep;
+                bool hasRemove = face[0] == c.remove || face[1] == c.remove || face[2] == c.remove;
+                if (hasKeep && hasRemove) continue;
+
+                std::array<Point3D, 3> corners;
+                for (int i = 0; i < 3; ++i) {
+                    corners[i] = face[i] == moved ? c.position : mesh.vertices[face[i]];
+                }
+                Point3D before = faceNormal(mesh.vertices[face[0]], mesh.vertices[face[1]], mesh.vertices[face[2]]);
+                Point3D after = faceNormal(corners[0], corners[1], corners[2]);
+                if (dot(before, after) <= 0.0) return false;
+            }
+        }
+        return true;
+    }
+
+    // Returns the number of faces removed
+    size_t collapse(const Candidate& c) {
+        size_t removed = 0;
+        mesh.vertices[c.keep] = c.position;
+        quadrics[c.keep] += quadrics[c.remove];
+
+        for (uint32_t f : vertexFaces[c.remove]) {
+            auto& face = mesh.faces[f];
+            if (face[0] == c.keep || face[1] == c.keep || face[2] == c.keep) {
+                faceAlive[f] = 0;
+                removed++;
+                continue;
+            }
+            for (auto& v : face) {
+                if (v == c.remove) v = c.keep;
+            }
+            vertexFaces[c.keep].push_back(f);
+        }
+        vertexFaces[c.remove].clear();
+        vertexAlive[c.remove] = 0;
+
+        // Drop dead faces from the lists of the surviving ring
+        for (uint32_t w : neighbours(c.keep)) {
+            auto& faces = vertexFaces[w];
+            faces.erase(std::remove_if(faces.begin(), faces.end(), [this](uint32_t f) { return !faceAlive[f]; }), faces.end());
+        }
+        auto& keepFaces = vertexFaces[c.keep];
+        keepFaces.erase(std::remove_if(keepFaces.begin(), keepFaces.end(), [this](uint32_t f) { return !faceAlive[f]; }), keepFaces.end());
+
+        version[c.keep]++;
+        version[c.remove]++;
+        return removed;
+    }
+
+    // Collapse cheapest-first inside one slab (or everywhere for BORDER),
+    // seeded from the given faces, until faceCount reaches faceTarget or no
+    // candidate is left
+    size_t run(int32_t partition, const std::vector<uint32_t>& seedFaces, size_t faceCount, size_t faceTarget) {
+        CandidateQueue queue;
+        Candidate candidate;
+
+        for (uint32_t f : seedFaces) {
+            if (!faceAlive[f]) continue;
+            const auto& face = mesh.faces[f];
+            for (int i = 0; i < 3; ++i) {
+                uint32_t a = face[i];
+                uint32_t b = face[(i + 1) % 3];
+                if (a < b && eligible(a, partition) && eligible(b, partition) && evaluate(a, b, candidate)) {
+                    queue.push(candidate);
+                }
+            }
+        }
+
+        size_t removed = 0;
+        while (!queue.empty() && faceCount - removed > faceTarget) {
+            Candidate c = queue.top();
+            queue.pop();
+
+            // Lazy update: entries for vertices changed since they were queued are stale
+            if (!vertexAlive[c.keep] || !vertexAlive[c.remove] ||
+                version[c.keep] != c.keepVersion || version[c.remove] != c.removeVersion) {
+                continue;
+            }
+            if (!canCollapse(c)) continue;
+
+            removed += collapse(c);
+
+            for (uint32_t w : neighbours(c.keep)) {
+                if (eligible(w, partition) && evaluate(std::min(c.keep, w), std::max(c.keep, w), candidate)) {
+                    queue.push(candidate);
+                }
+            }
+        }
+        return removed;
+    }
+};
+
+} // namespace
+
+MeshDecimator::MeshDecimator()
+    : targetFaceCount_(0), minEdgeLength_(0.0), featureAngle_(30.0), partitionCount_(0) {
+}
+
+MeshDecimator MeshDecimator::fromFrequency(const FrequencyCalculator& frequency, double divisions) {
+    MeshDecimator decimator;
+    if (frequency.isValidFrequency() && divisions > 0.0) {
+        decimator.setMinEdgeLength(frequency.getWavelength() / divisions);
+    }
+    return decimator;
+}
+
+std::vector<Triangle> MeshDecimator::decimate(const std::vector<Triangle>& triangles) const {
+    IndexedMesh mesh = decimate(MeshTopology::buildIndexedMesh(triangles));
+
+    std::vector<Triangle> result;
+    result.reserve(mesh.faceCount());
+    for (size_t f = 0; f < mesh.faceCount(); ++f) {
+        result.push_back(mesh.triangle(f));
+    }
+    return result;
+}
+
+IndexedMesh MeshDecimator::decimate(const IndexedMesh& input) const {
+    const size_t minFacesPerPartition = 20000;
+
+    // Without a face target or a length limit every edge would be fair game
+    if (input.faces.empty() || (targetFaceCount_ == 0 && minEdgeLength_ <= 0.0)) {
+        return input;
+    }
+
+    CollapseState state;
+    state.mesh = input;
+    state.minEdgeSquared = minEdgeLength_ * minEdgeLength_;
+
+    size_t vertexCount = input.vertexCount();
+    size_t faceCount = input.faceCount();
+    state.vertexFaces.resize(vertexCount);
+    state.quadrics.resize(vertexCount);
+    state.vertexAlive.assign(vertexCount, 1);
+    state.faceAlive.assign(faceCount, 1);
+    state.version.assign(vertexCount, 0);
+
+    // Area-weighted plane quadrics; welded-away faces are dropped up front
+    size_t aliveFaces = 0;
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        const auto& face = input.faces[f];
+        if (face[0] == face[1] || face[1] == face[2] || face[0] == face[2]) {
+            state.faceAlive[f] = 0;
+            continue;
+        }
+        aliveFaces++;
+
+        Point3D normal = faceNormal(input.vertices[face[0]], input.vertices[face[1]], input.vertices[face[2]]);
+        double length = std::sqrt(dot(normal, normal));
+        Quadric plane;
+        if (length > 0.0) {
+            plane = Quadric::fromPlane(normal * (1.0 / length), input.vertices[face[0]], length / 2.0);
+        }
+        for (uint32_t v : face) {
+            state.vertexFaces[v].push_back(f);
+            state.quadrics[v] += plane;
+        }
+    }
+
+    std::vector<uint32_t> degree = SurfaceRemesher::featureDegrees(input, featureAngle_);
+    state.pinned.resize(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        state.pinned[v] = degree[v] > 0;
+    }
+
+    // Slabs of equal vertex count along the longest extent
+    unsigned partitions = partitionCount_ > 0 ? partitionCount_ : ThreadPool::getInstance().getThreadCount();
+    partitions = static_cast<unsigned>(std::min<size_t>(partitions, aliveFaces / minFacesPerPartition));
+    state.slab.assign(vertexCount, 0);
+
+    if (partitions > 1) {
+        BoundingBox bbox(input.vertices.front(), input.vertices.front());
+        for (const auto& v : input.vertices) bbox.expand(v);
+        Point3D size = bbox.size();
+        int axis = size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2);
+        auto coordinate = [&input, axis](uint32_t v) {
+            const Point3D& p = input.vertices[v];
+            return axis == 0 ? p.x : (axis == 1 ? p.y : p.z);
+        };
+
+        std::vector<uint32_t> order(vertexCount);
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [&coordinate](uint32_t a, uint32_t b) {
+            double ca = coordinate(a), cb = coordinate(b);
+            return ca != cb ? ca < cb : a < b;
+        });
+        for (size_t rank = 0; rank < vertexCount; ++rank) {
+            state.slab[order[rank]] = static_cast<int32_t>(rank * partitions / vertexCount);
+        }
+
+        // Faces spanning two slabs freeze all their vertices for the slab passes
+        std::vector<std::vector<uint32_t>> slabFaces(partitions);
+        std::vector<uint8_t> border(vertexCount, 0);
+        for (uint32_t f = 0; f < faceCount; ++f) {
+            if (!state.faceAlive[f]) continue;
+            const auto& face = input.faces[f];
+            int32_t s = state.slab[face[0]];
+            if (state.slab[face[1]] == s && state.slab[face[2]] == s) {
+                slabFaces[s].push_back(f);
+            } else {
+                border[face[0]] = border[face[1]] = border[face[2]] = 1;
+            }
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            if (border[v]) state.slab[v] = BORDER;
+        }
+
+        std::vector<size_t> removed(partitions, 0);
+        ThreadPool::getInstance().parallelFor(partitions, [&](size_t begin, size_t end) {
+            for (size_t p = begin; p < end; ++p) {
+                size_t target = targetFaceCount_ * slabFaces[p].size() / std::max<size_t>(aliveFaces, 1);
+                removed[p] = state.run(static_cast<int32_t>(p), slabFaces[p], slabFaces[p].size(), target);
+            }
+        });
+        for (size_t count : removed) {
+            aliveFaces -= count;
+        }
+    }
+
+    // Whole-mesh pass picks up the slab rims and any remaining budget
+    std::vector<uint32_t> allFaces(faceCount);
+    std::iota(allFaces.begin(), allFaces.end(), 0u);
+    aliveFaces -= state.run(BORDER, allFaces, aliveFaces, targetFaceCount_);
+
+    // Compact the surviving faces and the vertices they use
+    IndexedMesh result;
+    result.faces.reserve(aliveFaces);
+    std::vector<uint32_t> remap(vertexCount, 0xFFFFFFFFu);
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        if (!state.faceAlive[f]) continue;
+        std::array<uint32_t, 3> face;
+        for (int i = 0; i < 3; ++i) {
+            uint32_t v = state.mesh.faces[f][i];
+            if (remap[v] == 0xFFFFFFFFu) {
+                remap[v] = static_cast<uint32_t>(result.vertices.size());
+                result.vertices.push_back(state.mesh.vertices[v]);
+            }
+            face[i] = remap[v];
+        }
+        result.faces.push_back(face);
+    }
+
+    return result;
+}
+
+} // namespace stl_to_eznec
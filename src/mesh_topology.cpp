@@ -0,0 +1,421 @@
+#include "mesh_topology.h"
+#include "thread_pool.h"
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include <unordered_set>
+#include <unordered_map>
+
+namespace stl_to_eznec {
+
+ComponentView::ComponentView(std::shared_ptr<const ComponentMesh> source, uint32_t componentId)
+    : source(std::move(source)), componentId(componentId), offset(0), count(0) {
+    const ComponentTable& table = this->source->components;
+    offset = table.offsets[componentId];
+    count = table.offsets[componentId + 1] - offset;
+}
+
+std::vector<Triangle> ComponentView::materialize() const {
+    std::vector<Triangle> triangles;
+    if (empty()) return triangles;
+
+    triangles.reserve(count);
+    for (uint32_t face : *this) {
+        triangles.push_back(source->mesh.triangle(face));
+    }
+    return triangles;
+}
+
+std::vector<uint32_t> ComponentView::vertexIds() const {
+    std::vector<uint32_t> ids;
+    if (empty()) return ids;
+
+    ids.reserve(count * 3);
+    for (uint32_t face : *this) {
+        const auto& f = source->mesh.faces[face];
+        ids.insert(ids.end(), f.begin(), f.end());
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+SpatialHash::SpatialHash(double cellSize)
+    : cellSize_(cellSize > 0 ? cellSize : 1e-6) {
+}
+
+void SpatialHash::reserve(size_t count) {
+    heads_.reserve(count);
+    next_.reserve(count);
+    points_.reserve(count);
+    ids_.reserve(count);
+}
+
+int64_t SpatialHash::cellCoordinate(double value) const {
+    return static_cast<int64_t>(std::floor(value / cellSize_));
+}
+
+uint64_t SpatialHash::cellKey(int64_t ix, int64_t iy, int64_t iz) {
+    // Hash collisions only share a chain; distances are always checked
+    return static_cast<uint64_t>(ix) * 73856093ULL ^
+           static_cast<uint64_t>(iy) * 19349663ULL ^
+           static_cast<uint64_t>(iz) * 83492791ULL;
+}
+
+void SpatialHash::insert(const Point3D& point, uint32_t id) {
+    uint64_t key = cellKey(cellCoordinate(point.x), cellCoordinate(point.y), cellCoordinate(point.z));
+    uint32_t entry = static_cast<uint32_t>(points_.size());
+
+    points_.push_back(point);
+    ids_.push_back(id);
+
+    auto result = heads_.emplace(key, entry);
+    if (result.second) {
+        next_.push_back(NO_ENTRY);
+    } else {
+        next_.push_back(result.first->second);
+        result.first->second = entry;
+    }
+}
+
+int64_t SpatialHash::findNear(const Point3D& point, double tolerance) const {
+    int64_t cx = cellCoordinate(point.x);
+    int64_t cy = cellCoordinate(point.y);
+    int64_t cz = cellCoordinate(point.z);
+    int64_t reach = static_cast<int64_t>(std::ceil(tolerance / cellSize_));
+    double toleranceSquared = tolerance * tolerance;
+
+    for (int64_t ix = cx - reach; ix <= cx + reach; ++ix) {
+        for (int64_t iy = cy - reach; iy <= cy + reach; ++iy) {
+            for (int64_t iz = cz - reach; iz <= cz + reach; ++iz) {
+                auto it = heads_.find(cellKey(ix, iy, iz));
+                if (it == heads_.end()) continue;
+
+                for (uint32_t entry = it->second; entry != NO_ENTRY; entry = next_[entry]) {
+                    const Point3D& candidate = points_[entry];
+                    double dx = candidate.x - point.x;
+                    double dy = candidate.y - point.y;
+                    double dz = candidate.z - point.z;
+                    if (dx*dx + dy*dy + dz*dz <= toleranceSquared) {
+                        return ids_[entry];
+                    }
+                }
+            }
+        }
+    }
+
+    return -1;
+}
+
+int64_t SpatialHash::findNearest(const Point3D& point, double tolerance) const {
+    int64_t cx = cellCoordinate(point.x);
+    int64_t cy = cellCoordinate(point.y);
+    int64_t cz = cellCoordinate(point.z);
+    int64_t reach = static_cast<int64_t>(std::ceil(tolerance / cellSize_));
+    double nearestSquared = tolerance * tolerance;
+    int64_t nearest = -1;
+
+    for (int64_t ix = cx - reach; ix <= cx + reach; ++ix) {
+        for (int64_t iy = cy - reach; iy <= cy + reach; ++iy) {
+            for (int64_t iz = cz - reach; iz <= cz + reach; ++iz) {
+                auto it = heads_.find(cellKey(ix, iy, iz));
+                if (it == heads_.end()) continue;
+
+                for (uint32_t entry = it->second; entry != NO_ENTRY; entry = next_[entry]) {
+                    const Point3D& candidate = points_[entry];
+                    double dx = candidate.x - point.x;
+                    double dy = candidate.y - point.y;
+                    double dz = candidate.z - point.z;
+                    double distanceSquared = dx*dx + dy*dy + dz*dz;
+                    if (distanceSquared < nearestSquared ||
+                        (distanceSquared == nearestSquared && (nearest < 0 || ids_[entry] < nearest))) {
+                        nearestSquared = distanceSquared;
+                        nearest = ids_[entry];
+                    }
+                }
+            }
+        }
+    }
+
+    return nearest;
+}
+
+IndexedMesh MeshTopology::buildIndexedMesh(const std::vector<Triangle>& triangles, double weldTolerance) {
+    IndexedMesh mesh;
+    mesh.faces.reserve(triangles.size());
+    mesh.vertices.reserve(triangles.size() / 2 + 3);
+
+    SpatialHash hash(weldTolerance);
+    hash.reserve(triangles.size() / 2 + 3);
+
+    for (const auto& triangle : triangles) {
+        std::array<uint32_t, 3> face;
+        for (int i = 0; i < 3; ++i) {
+            const Point3D& vertex = triangle.vertices[i];
+            int64_t existing = hash.findNear(vertex, weldTolerance);
+
+            if (existing >= 0) {
+                face[i] = static_cast<uint32_t>(existing);
+            } else {
+                face[i] = static_cast<uint32_t>(mesh.vertices.size());
+                hash.insert(vertex, face[i]);
+                mesh.vertices.push_back(vertex);
+            }
+        }
+        mesh.faces.push_back(face);
+    }
+
+    return mesh;
+}
+
+namespace {
+
+uint32_t findRoot(std::vector<uint32_t>& parent, uint32_t node) {
+    while (parent[node] != node) {
+        parent[node] = parent[parent[node]];
+        node = parent[node];
+    }
+    return node;
+}
+
+} // namespace
+
+ComponentTable MeshTopology::findConnectedComponents(const IndexedMesh& mesh) {
+    ComponentTable table;
+    size_t faceCount = mesh.faceCount();
+
+    // Union-find over faces, joined through the first face seen at each vertex
+    std::vector<uint32_t> parent(faceCount);
+    std::iota(parent.begin(), parent.end(), 0u);
+    std::vector<uint32_t> vertexOwner(mesh.vertexCount(), 0xFFFFFFFFu);
+
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        for (uint32_t v : mesh.faces[f]) {
+            if (vertexOwner[v] == 0xFFFFFFFFu) {
+                vertexOwner[v] = f;
+                continue;
+            }
+            uint32_t a = findRoot(parent, f);
+            uint32_t b = findRoot(parent, vertexOwner[v]);
+            if (a != b) {
+                parent[std::max(a, b)] = std::min(a, b);
+            }
+        }
+    }
+
+    // Number the components in order of their first face
+    table.faceComponent.assign(faceCount, 0);
+    std::vector<uint32_t> rootComponent(faceCount, 0xFFFFFFFFu);
+    uint32_t componentCount = 0;
+
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        uint32_t root = findRoot(parent, f);
+        if (rootComponent[root] == 0xFFFFFFFFu) {
+            rootComponent[root] = componentCount++;
+        }
+        table.faceComponent[f] = rootComponent[root];
+    }
+
+    // Counting sort of faces into CSR order
+    table.offsets.assign(componentCount + 1, 0);
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        table.offsets[table.faceComponent[f] + 1]++;
+    }
+    for (uint32_t c = 0; c < componentCount; ++c) {
+        table.offsets[c + 1] += table.offsets[c];
+    }
+
+    table.faces.resize(faceCount);
+    std::vector<uint32_t> cursor(table.offsets.begin(), table.offsets.end() - 1);
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        table.faces[cursor[table.faceComponent[f]]++] = f;
+    }
+
+    return table;
+}
+
+std::shared_ptr<const ComponentMesh> MeshTopology::buildComponentMesh(const std::vector<Triangle>& triangles, double weldTolerance) {
+    auto source = std::make_shared<ComponentMesh>();
+    source->mesh = buildIndexedMesh(triangles, weldTolerance);
+    source->components = findConnectedComponents(source->mesh);
+    return source;
+}
+
+std::vector<ComponentView> MeshTopology::componentViews(const std::shared_ptr<const ComponentMesh>& source) {
+    std::vector<ComponentView> views;
+    if (!source) return views;
+
+    views.reserve(source->components.size());
+    for (size_t c = 0; c < source->components.size(); ++c) {
+        views.emplace_back(source, static_cast<uint32_t>(c));
+    }
+    return views;
+}
+
+IndexedMesh MeshTopology::extractFaces(const IndexedMesh& mesh, const uint32_t* begin, const uint32_t* end) {
+    const uint32_t NONE = 0xFFFFFFFFu;
+    IndexedMesh result;
+    result.faces.reserve(end - begin);
+    std::vector<uint32_t> remap(mesh.vertexCount(), NONE);
+    for (const uint32_t* f = begin; f != end; ++f) {
+        std::array<uint32_t, 3> face = mesh.faces[*f];
+        for (auto& v : face) {
+            if (remap[v] == NONE) {
+                remap[v] = static_cast<uint32_t>(result.vertices.size());
+                result.vertices.push_back(mesh.vertices[v]);
+            }
+            v = remap[v];
+        }
+        result.faces.push_back(face);
+    }
+    return result;
+}
+
+IndexedMesh MeshTopology::clipToHalfSpace(const IndexedMesh& mesh, int axis, double offset) {
+    const uint32_t NONE = 0xFFFFFFFFu;
+    const uint64_t NO_EDGE = ~0ull;
+    ThreadPool& pool = ThreadPool::getInstance();
+
+    auto coordinate = [axis](const Point3D& p) { return axis == 0 ? p.x : (axis == 1 ? p.y : p.z); };
+    auto edgeKey = [](uint32_t a, uint32_t b) {
+        return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+    };
+
+    std::vector<uint8_t> keep(mesh.vertexCount());
+    pool.parallelFor(mesh.vertexCount(), [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            keep[v] = coordinate(mesh.vertices[v]) >= offset;
+        }
+    }, 8192);
+
+    // Per face: output face count and the (up to two) crossing edges it cuts
+    size_t faceCount = mesh.faceCount();
+    std::vector<uint8_t> produced(faceCount);
+    std::vector<uint64_t> crossings(2 * faceCount, NO_EDGE);
+    pool.parallelFor(faceCount, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            const auto& face = mesh.faces[f];
+            int kept = keep[face[0]] + keep[face[1]] + keep[face[2]];
+            produced[f] = kept == 3 ? 1 : (kept == 2 ? 2 : kept);
+            if (kept == 1 || kept == 2) {
+                int slot = 0;
+                for (int i = 0; i < 3; ++i) {
+                    uint32_t a = face[i], b = face[(i + 1) % 3];
+                    if (keep[a] != keep[b]) crossings[2 * f + slot++] = edgeKey(a, b);
+                }
+            }
+        }
+    }, 8192);
+
+    // Cut points in edge-key order, so the output does not depend on threading
+    std::vector<uint64_t> cuts;
+    for (uint64_t key : crossings) {
+        if (key != NO_EDGE) cuts.push_back(key);
+    }
+    std::sort(cuts.begin(), cuts.end());
+    cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+
+    // Kept vertices that some face still uses, in their original order
+    std::vector<uint32_t> remap(mesh.vertexCount(), NONE);
+    uint32_t keptCount = 0;
+    for (const auto& face : mesh.faces) {
+        for (uint32_t v : face) {
+            if (keep[v]) remap[v] = 0;
+        }
+    }
+    for (uint32_t v = 0; v < mesh.vertexCount(); ++v) {
+        if (remap[v] == 0) remap[v] = keptCount++;
+    }
+
+    std::vector<size_t> firstFace(faceCount + 1, 0);
+    for (size_t f = 0; f < faceCount; ++f) {
+        firstFace[f + 1] = firstFace[f] + produced[f];
+    }
+
+    IndexedMesh result;
+    result.vertices.resize(keptCount + cuts.size());
+    result.faces.resize(firstFace[faceCount]);
+
+    for (uint32_t v = 0; v < mesh.vertexCount(); ++v) {
+        if (keep[v] && remap[v] != NONE) result.vertices[remap[v]] = mesh.vertices[v];
+    }
+    pool.parallelFor(cuts.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Point3D& pa = mesh.vertices[static_cast<uint32_t>(cuts[i] >> 32)];
+            const Point3D& pb = mesh.vertices[static_cast<uint32_t>(cuts[i] & 0xFFFFFFFFu)];
+            double t = (offset - coordinate(pa)) / (coordinate(pb) - coordinate(pa));
+            Point3D cut = pa + (pb - pa) * t;
+            (axis == 0 ? cut.x : (axis == 1 ? cut.y : cut.z)) = offset;
+            result.vertices[keptCount + i] = cut;
+        }
+    }, 4096);
+
+    // One cut point per crossing edge, shared by both faces on that edge
+    auto cutVertex = [&](uint32_t a, uint32_t b) {
+        auto found = std::lower_bound(cuts.begin(), cuts.end(), edgeKey(a, b));
+        return keptCount + static_cast<uint32_t>(found - cuts.begin());
+    };
+
+    pool.parallelFor(faceCount, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            const auto& face = mesh.faces[f];
+            auto out = result.faces.begin() + firstFace[f];
+            int kept = keep[face[0]] + keep[face[1]] + keep[face[2]];
+
+            if (kept == 3) {
+                *out = {remap[face[0]], remap[face[1]], remap[face[2]]};
+            } else if (kept == 1) {
+                // Rotate so the kept corner comes first; winding is preserved
+                int k = keep[face[0]] ? 0 : (keep[face[1]] ? 1 : 2);
+                uint32_t a = face[k], b = face[(k + 1) % 3], c = face[(k + 2) % 3];
+                *out = {remap[a], cutVertex(a, b), cutVertex(c, a)};
+            } else if (kept == 2) {
+                int d = !keep[face[0]] ? 0 : (!keep[face[1]] ? 1 : 2);
+                uint32_t a = face[d], b = face[(d + 1) % 3], c = face[(d + 2) % 3];
+                uint32_t ab = cutVertex(a, b);
+                uint32_t ca = cutVertex(c, a);
+                out[0] = {ab, remap[b], remap[c]};
+                out[1] = {ab, remap[c], ca};
+            }
+        }
+    }, 4096);
+
+    return result;
+}
+
+WireGraph MeshTopology::buildEdgeGraph(const IndexedMesh& mesh) {
+    WireGraph graph;
+    graph.nodes = mesh.vertices;
+    graph.edges.reserve(mesh.faceCount() * 3 / 2);
+
+    // An interior edge of a closed surface belongs to two faces; keep it once
+    std::unordered_set<uint64_t> seen;
+    seen.reserve(mesh.faceCount() * 3 / 2);
+
+    for (const auto& face : mesh.faces) {
+        for (int i = 0; i < 3; ++i) {
+            uint32_t a = std::min(face[i], face[(i + 1) % 3]);
+            uint32_t b = std::max(face[i], face[(i + 1) % 3]);
+            if (a == b) continue;
+
+            if (seen.insert((static_cast<uint64_t>(a) << 32) | b).second) {
+                graph.edges.push_back({a, b});
+            }
+        }
+    }
+
+    return graph;
+}
+
+std::vector<Triangle> MeshTopology::extractComponent(const IndexedMesh& mesh, const ComponentTable& components, size_t component) {
+    std::vector<Triangle> triangles;
+    triangles.reserve(components.faceCount(component));
+
+    for (uint32_t i = components.offsets[component]; i < components.offsets[component + 1]; ++i) {
+        triangles.push_back(mesh.triangle(components.faces[i]));
+    }
+
+    return triangles;
+}
+
+} // namespace stl_to_eznec
@@ -0,0 +1,241 @@
+#include "nec_deck.h"
+#include "thread_pool.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace stl_to_eznec {
+
+namespace {
+
+// Spread the low 21 bits of v to every third bit
+uint64_t spreadBits(uint64_t v) {
+    v &= 0x1FFFFF;
+    v = (v | (v << 32)) & 0x1F00000000FFFFull;
+    v = (v | (v << 16)) & 0x1F0000FF0000FFull;
+    v = (v | (v << 8)) & 0x100F00F00F00F00Full;
+    v = (v | (v << 4)) & 0x10C30C30C30C30C3ull;
+    v = (v | (v << 2)) & 0x1249249249249249ull;
+    return v;
+}
+
+template<typename T>
+void permute(std::vector<T>& column, size_t begin, const std::vector<uint32_t>& order) {
+    std::vector<T> sorted(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        sorted[i] = column[order[i]];
+    }
+    std::copy(sorted.begin(), sorted.end(), column.begin() + begin);
+}
+
+template<typename T>
+void compact(std::vector<T>& column, const std::vector<uint8_t>& kept) {
+    size_t out = 0;
+    for (size_t i = 0; i < column.size(); ++i) {
+        if (kept[i]) column[out++] = column[i];
+    }
+    column.resize(out);
+}
+
+} // namespace
+
+void NECDeck::reserve(size_t count) {
+    tags.reserve(count);
+    segments.reserve(count);
+    starts.reserve(count);
+    ends.reserve(count);
+    radii.reserve(count);
+}
+
+void NECDeck::resize(size_t count) {
+    tags.resize(count, 0);
+    segments.resize(count, 0);
+    starts.resize(count);
+    ends.resize(count);
+    radii.resize(count, 0.0);
+}
+
+void NECDeck::clear() {
+    tags.clear();
+    segments.clear();
+    starts.clear();
+    ends.clear();
+    radii.clear();
+}
+
+void NECDeck::push_back(const NECWire& wire) {
+    tags.push_back(wire.tag);
+    segments.push_back(wire.segments);
+    starts.push_back(wire.start);
+    ends.push_back(wire.end);
+    radii.push_back(wire.radius);
+}
+
+void NECDeck::set(size_t index, const NECWire& wire) {
+    tags[index] = wire.tag;
+    segments[index] = wire.segments;
+    starts[index] = wire.start;
+    ends[index] = wire.end;
+    radii[index] = wire.radius;
+}
+
+void NECDeck::append(const NECDeck& other) {
+    tags.insert(tags.end(), other.tags.begin(), other.tags.end());
+    segments.insert(segments.end(), other.segments.begin(), other.segments.end());
+    starts.insert(starts.end(), other.starts.begin(), other.starts.end());
+    ends.insert(ends.end(), other.ends.begin(), other.ends.end());
+    radii.insert(radii.end(), other.radii.begin(), other.radii.end());
+}
+
+void NECDeck::renumber(int firstTag) {
+    ThreadPool::getInstance().parallelFor(size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            tags[i] = firstTag + static_cast<int>(i);
+        }
+    }, 16384);
+}
+
+std::vector<uint32_t> NECDeck::sortByLocality(size_t begin, size_t end) {
+    end = std::min(end, size());
+    std::vector<uint32_t> order;
+    if (begin >= end) return order;
+
+    Point3D low(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+                std::numeric_limits<double>::max());
+    Point3D high(-low.x, -low.y, -low.z);
+    for (size_t i = begin; i < end; ++i) {
+        Point3D mid = (starts[i] + ends[i]) * 0.5;
+        low = Point3D(std::min(low.x, mid.x), std::min(low.y, mid.y), std::min(low.z, mid.z));
+        high = Point3D(std::max(high.x, mid.x), std::max(high.y, mid.y), std::max(high.z, mid.z));
+    }
+    // One scale for all axes keeps the curve's cells cubic
+    double extent = std::max({high.x - low.x, high.y - low.y, high.z - low.z});
+    double scale = extent > 0.0 ? 2097151.0 / extent : 0.0;
+
+    std::vector<std::pair<uint64_t, uint32_t>> keys(end - begin);
+    ThreadPool::getInstance().parallelFor(keys.size(), [&](size_t first, size_t last) {
+        for (size_t k = first; k < last; ++k) {
+            size_t i = begin + k;
+            Point3D mid = (starts[i] + ends[i]) * 0.5;
+            uint64_t code = spreadBits(static_cast<uint64_t>((mid.x - low.x) * scale)) |
+                            (spreadBits(static_cast<uint64_t>((mid.y - low.y) * scale)) << 1) |
+                            (spreadBits(static_cast<uint64_t>((mid.z - low.z) * scale)) << 2);
+            keys[k] = {code, static_cast<uint32_t>(i)};
+        }
+    }, 16384);
+    std::sort(keys.begin(), keys.end());
+
+    order.resize(keys.size());
+    for (size_t k = 0; k < keys.size(); ++k) {
+        order[k] = keys[k].second;
+    }
+    permute(tags, begin, order);
+    permute(segments, begin, order);
+    permute(starts, begin, order);
+    permute(ends, begin, order);
+    permute(radii, begin, order);
+    return order;
+}
+
+size_t NECDeck::filter(const std::function<bool(size_t)>& keep) {
+    std::vector<uint8_t> kept(size());
+    ThreadPool::getInstance().parallelFor(size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            kept[i] = keep(i) ? 1 : 0;
+        }
+    }, 16384);
+
+    size_t before = size();
+    compact(tags, kept);
+    compact(segments, kept);
+    compact(starts, kept);
+    compact(ends, kept);
+    compact(radii, kept);
+    return before - size();
+}
+
+DeckStatistics NECDeck::statistics() const {
+    DeckStatistics result;
+    if (empty()) return result;
+
+    const double INF = std::numeric_limits<double>::max();
+    result.minSegmentLength = INF;
+    result.minRadius = INF;
+    result.minLengthToRadius = INF;
+    result.minCorner = Point3D(INF, INF, INF);
+    result.maxCorner = Point3D(-INF, -INF, -INF);
+
+    // Fixed blocks, reduced in block order, so the totals do not depend on
+    // the thread count or on which block finishes first
+    const size_t BLOCK = 16384;
+    std::vector<DeckStatistics> parts((size() + BLOCK - 1) / BLOCK, result);
+    ThreadPool::getInstance().parallelFor(parts.size(), [&](size_t firstBlock, size_t lastBlock) {
+        for (size_t block = firstBlock; block < lastBlock; ++block) {
+            DeckStatistics& part = parts[block];
+            size_t end = std::min(size(), (block + 1) * BLOCK);
+            for (size_t i = block * BLOCK; i < end; ++i) {
+                double length = starts[i].distance(ends[i]);
+                double segmentLength = length / std::max(segments[i], 1);
+                part.segments += segments[i];
+                part.totalLength += length;
+                part.minSegmentLength = std::min(part.minSegmentLength, segmentLength);
+                part.maxSegmentLength = std::max(part.maxSegmentLength, segmentLength);
+                part.minRadius = std::min(part.minRadius, radii[i]);
+                part.maxRadius = std::max(part.maxRadius, radii[i]);
+                if (radii[i] > 0.0) {
+                    part.minLengthToRadius = std::min(part.minLengthToRadius, segmentLength / radii[i]);
+                }
+                for (const Point3D& p : {starts[i], ends[i]}) {
+                    part.minCorner = Point3D(std::min(part.minCorner.x, p.x), std::min(part.minCorner.y, p.y),
+                                             std::min(part.minCorner.z, p.z));
+                    part.maxCorner = Point3D(std::max(part.maxCorner.x, p.x), std::max(part.maxCorner.y, p.y),
+                                             std::max(part.maxCorner.z, p.z));
+                }
+            }
+        }
+    });
+
+    for (const auto& part : parts) {
+        result.segments += part.segments;
+        result.totalLength += part.totalLength;
+        result.minSegmentLength = std::min(result.minSegmentLength, part.minSegmentLength);
+        result.maxSegmentLength = std::max(result.maxSegmentLength, part.maxSegmentLength);
+        result.minRadius = std::min(result.minRadius, part.minRadius);
+        result.maxRadius = std::max(result.maxRadius, part.maxRadius);
+        result.minLengthToRadius = std::min(result.minLengthToRadius, part.minLengthToRadius);
+        result.minCorner = Point3D(std::min(result.minCorner.x, part.minCorner.x),
+                                   std::min(result.minCorner.y, part.minCorner.y),
+                                   std::min(result.minCorner.z, part.minCorner.z));
+        result.maxCorner = Point3D(std::max(result.maxCorner.x, part.maxCorner.x),
+                                   std::max(result.maxCorner.y, part.maxCorner.y),
+                                   std::max(result.maxCorner.z, part.maxCorner.z));
+    }
+
+    result.wires = size();
+    if (result.minLengthToRadius == INF) result.minLengthToRadius = 0.0;
+    return result;
+}
+
+void NECDeck::printStatistics(const DeckStatistics& statistics) {
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(1);
+    report << "\n=== Wire Deck ===\n";
+    report << "Wires: " << statistics.wires << ", segments: " << statistics.segments << ", total length: "
+           << statistics.totalLength << " m\n";
+    if (statistics.wires > 0) {
+        report << "Segment length: " << statistics.minSegmentLength * 100.0 << " to "
+               << statistics.maxSegmentLength * 100.0 << " cm\n";
+        report << "Wire radius: " << std::setprecision(2) << statistics.minRadius * 1000.0 << " to "
+               << statistics.maxRadius * 1000.0 << " mm\n";
+        report << "Shortest segment / radius: " << std::setprecision(1) << statistics.minLengthToRadius << "\n";
+        if (statistics.minLengthToRadius > 0.0 && statistics.minLengthToRadius < 2.0) {
+            report << "WARNING: Segments shorter than two radii break the thin-wire approximation.\n";
+        }
+    }
+    std::cout << report.str();
+}
+
+} // namespace stl_to_eznec
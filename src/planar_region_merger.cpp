@@ -0,0 +1,211 @@
+#include "planar_region_merger.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace stl_to_eznec {
+
+namespace {
+
+uint64_t edgeKey(uint32_t a, uint32_t b) {
+    if (a > b) std::swap(a, b);
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+double dot(const Point3D& a, const Point3D& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+Point3D cross(const Point3D& a, const Point3D& b) {
+    return Point3D(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+Point3D normalized(const Point3D& p) {
+    double length = std::sqrt(dot(p, p));
+    return length > 0.0 ? p * (1.0 / length) : Point3D();
+}
+
+// Any unit vector perpendicular to n
+Point3D perpendicular(const Point3D& n) {
+    Point3D axis = std::abs(n.x) < 0.9 ? Point3D(1, 0, 0) : Point3D(0, 1, 0);
+    return normalized(cross(n, axis));
+}
+
+struct EdgeFaces {
+    uint32_t count;
+    uint32_t faces[2];
+};
+
+} // namespace
+
+PlanarRegionMerger::PlanarRegionMerger(double angleToleranceDegrees)
+    : angleTolerance_(angleToleranceDegrees), planeTolerance_(1e-3), minArea_(0) {
+}
+
+std::vector<PlanarRegion> PlanarRegionMerger::merge(const IndexedMesh& mesh, const std::vector<int32_t>& faceGroup) const {
+    std::vector<PlanarRegion> regions;
+    if (mesh.faces.empty()) return regions;
+
+    // Unit normals and areas; welded slivers get a zero normal and never join
+    std::vector<Point3D> normals(mesh.faceCount());
+    std::vector<double> areas(mesh.faceCount());
+    ThreadPool::getInstance().parallelFor(mesh.faceCount(), [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            const auto& face = mesh.faces[f];
+            Point3D n = cross(mesh.vertices[face[1]] - mesh.vertices[face[0]],
+                              mesh.vertices[face[2]] - mesh.vertices[face[0]]);
+            areas[f] = 0.5 * std::sqrt(dot(n, n));
+            normals[f] = normalized(n);
+        }
+    }, 4096);
+
+    std::unordered_map<uint64_t, EdgeFaces> edgeFaces;
+    edgeFaces.reserve(mesh.faceCount() * 3 / 2);
+    for (uint32_t f = 0; f < mesh.faceCount(); ++f) {
+        const auto& face = mesh.faces[f];
+        for (int i = 0; i < 3; ++i) {
+            if (face[i] == face[(i + 1) % 3]) continue;
+            EdgeFaces& use = edgeFaces.emplace(edgeKey(face[i], face[(i + 1) % 3]), EdgeFaces{0, {0, 0}}).first->second;
+            if (use.count < 2) use.faces[use.count] = f;
+            use.count++;
+        }
+    }
+
+    // Seeds in decreasing area, so a region starts from its best-defined plane
+    std::vector<uint32_t> order(mesh.faceCount());
+    for (uint32_t f = 0; f < order.size(); ++f) {
+        order[f] = f;
+    }
+    std::stable_sort(order.begin(), order.end(), [&areas](uint32_t a, uint32_t b) { return areas[a] > areas[b]; });
+
+    const uint32_t NONE = 0xFFFFFFFFu;
+    double cosLimit = std::cos(angleTolerance_ * M_PI / 180.0);
+    std::vector<uint32_t> region(mesh.faceCount(), NONE);
+    std::vector<uint32_t> queue;
+
+    for (uint32_t seed : order) {
+        if (region[seed] != NONE || areas[seed] <= 0.0) continue;
+
+        const Point3D& n = normals[seed];
+        double offset = dot(n, mesh.vertices[mesh.faces[seed][0]]);
+        uint32_t id = static_cast<uint32_t>(regions.size());
+        regions.emplace_back();
+        PlanarRegion& grown = regions.back();
+
+        region[seed] = id;
+        queue.assign(1, seed);
+        for (size_t head = 0; head < queue.size(); ++head) {
+            uint32_t f = queue[head];
+            grown.faces.push_back(f);
+            const auto& face = mesh.faces[f];
+            for (int i = 0; i < 3; ++i) {
+                auto it = edgeFaces.find(edgeKey(face[i], face[(i + 1) % 3]));
+                if (it == edgeFaces.end() || it->second.count != 2) continue;
+
+                uint32_t g = it->second.faces[0] == f ? it->second.faces[1] : it->second.faces[0];
+                if (region[g] != NONE || areas[g] <= 0.0) continue;
+                if (!faceGroup.empty() && faceGroup[g] != faceGroup[seed]) continue;
+                // Either winding: an inconsistently oriented facet is still in the plane
+                if (std::abs(dot(normals[g], n)) < cosLimit) continue;
+
+                bool inPlane = true;
+                for (uint32_t v : mesh.faces[g]) {
+                    if (std::abs(dot(n, mesh.vertices[v]) - offset) > planeTolerance_) {
+                        inPlane = false;
+                        break;
+                    }
+                }
+                if (!inPlane) continue;
+
+                region[g] = id;
+                queue.push_back(g);
+            }
+        }
+    }
+
+    // Plane, boundary and axes of every region
+    ThreadPool::getInstance().parallelFor(regions.size(), [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            PlanarRegion& current = regions[r];
+            const Point3D& seedNormal = normals[current.faces.front()];
+
+            Point3D normal(0, 0, 0);
+            Point3D centroid(0, 0, 0);
+            for (uint32_t f : current.faces) {
+                double sign = dot(normals[f], seedNormal) < 0.0 ? -1.0 : 1.0;
+                normal = normal + normals[f] * (areas[f] * sign);
+                centroid = centroid + mesh.triangle(f).center() * areas[f];
+                current.area += areas[f];
+            }
+            if (current.area < minArea_ || current.area <= 0.0) continue;
+            current.normal = normalized(normal);
+            current.origin = centroid * (1.0 / current.area);
+
+            // Edges without a second facet in this region
+            for (uint32_t f : current.faces) {
+                const auto& face = mesh.faces[f];
+                for (int i = 0; i < 3; ++i) {
+                    uint32_t a = face[i];
+                    uint32_t b = face[(i + 1) % 3];
+                    if (a == b) continue;
+                    const EdgeFaces& use = edgeFaces.find(edgeKey(a, b))->second;
+                    bool shared = use.count == 2 && region[use.faces[0]] == r && region[use.faces[1]] == r;
+                    if (!shared) current.boundary.push_back({a, b});
+                }
+            }
+
+            // Dominant boundary direction from a length-weighted histogram of
+            // edge angles (mod 180 degrees), so rectangular panels get a lattice
+            // parallel to their sides
+            Point3D u0 = perpendicular(current.normal);
+            Point3D v0 = cross(current.normal, u0);
+            const int BINS = 180;
+            std::vector<double> histogram(BINS, 0.0);
+            for (const auto& edge : current.boundary) {
+                Point3D d = mesh.vertices[edge[1]] - mesh.vertices[edge[0]];
+                double length = std::sqrt(dot(d, d));
+                double angle = std::atan2(dot(d, v0), dot(d, u0));
+                if (angle < 0.0) angle += M_PI;
+                int bin = std::min(BINS - 1, static_cast<int>(angle / M_PI * BINS));
+                histogram[bin] += length;
+            }
+            int best = 0;
+            double bestWeight = -1.0;
+            for (int i = 0; i < BINS; ++i) {
+                double weight = histogram[(i + BINS - 1) % BINS] + histogram[i] + histogram[(i + 1) % BINS];
+                if (weight > bestWeight) {
+                    bestWeight = weight;
+                    best = i;
+                }
+            }
+            // Length-weighted mean angle over the peak bins refines the bin centre
+            double sumAngle = 0.0;
+            double sumWeight = 0.0;
+            double peak = (best + 0.5) * M_PI / BINS;
+            for (const auto& edge : current.boundary) {
+                Point3D d = mesh.vertices[edge[1]] - mesh.vertices[edge[0]];
+                double angle = std::atan2(dot(d, v0), dot(d, u0));
+                if (angle < 0.0) angle += M_PI;
+                double delta = angle - peak;
+                if (delta > M_PI / 2.0) delta -= M_PI;
+                if (delta < -M_PI / 2.0) delta += M_PI;
+                if (std::abs(delta) > 1.5 * M_PI / BINS) continue;
+                double length = std::sqrt(dot(d, d));
+                sumAngle += delta * length;
+                sumWeight += length;
+            }
+            double angle = peak + (sumWeight > 0.0 ? sumAngle / sumWeight : 0.0);
+            current.uAxis = normalized(u0 * std::cos(angle) + v0 * std::sin(angle));
+            current.vAxis = cross(current.normal, current.uAxis);
+        }
+    }, 64);
+
+    // Small regions are left to the facet path
+    regions.erase(std::remove_if(regions.begin(), regions.end(), [this](const PlanarRegion& r) {
+        return r.area < minArea_ || r.area <= 0.0;
+    }), regions.end());
+    return regions;
+}
+
+} // namespace stl_to_eznec
@@ -0,0 +1,257 @@
+#include "segment_planner.h"
+#include "thread_pool.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace stl_to_eznec {
+
+SegmentPlanner::SegmentPlanner()
+    : maxSegments_(10000), targetSolveSeconds_(300.0), factorRate_(1e9) {
+}
+
+MeshStatistics SegmentPlanner::measure(const IndexedMesh& mesh) {
+    MeshStatistics statistics;
+    statistics.faceCount = mesh.faceCount();
+
+    for (size_t f = 0; f < mesh.faceCount(); ++f) {
+        statistics.surfaceArea += mesh.triangle(f).area();
+    }
+
+    WireGraph edges = MeshTopology::buildEdgeGraph(mesh);
+    statistics.edgeCount = edges.edgeCount();
+    if (edges.empty()) return statistics;
+
+    statistics.minEdgeLength = edges.edgeLength(0);
+    for (size_t e = 0; e < edges.edgeCount(); ++e) {
+        double length = edges.edgeLength(e);
+        statistics.totalEdgeLength += length;
+        statistics.minEdgeLength = std::min(statistics.minEdgeLength, length);
+        statistics.maxEdgeLength = std::max(statistics.maxEdgeLength, length);
+    }
+    statistics.meanEdgeLength = statistics.totalEdgeLength / edges.edgeCount();
+
+    return statistics;
+}
+
+size_t SegmentPlanner::predictStructureSegments(const MeshStatistics& statistics, double gridSpacing) const {
+    if (gridSpacing <= 0.0 || (statistics.faceCount == 0 && statistics.wireLength <= 0.0)) return 0;
+
+    // Equilateral grid: 1.5 edges per triangle of area sqrt(3)/4 h^2, one segment each
+    double wires = 2.0 * std::sqrt(3.0) * statistics.surfaceArea / (gridSpacing * gridSpacing);
+    wires += statistics.wireLength / gridSpacing;
+    return static_cast<size_t>(std::ceil(wires));
+}
+
+size_t SegmentPlanner::predictStructureSegments(const IndexedMesh& mesh, const MeshStatistics& statistics,
+                                                const SpacingField& spacing) const {
+    if (!spacing.isGraded()) return predictStructureSegments(statistics, spacing.getNearSpacing());
+    if (spacing.getNearSpacing() <= 0.0) return 0;
+
+    // One distance query per facet, at its centroid. Fixed blocks fill their
+    // own slots, summed in block order so the prediction (and the pitch the
+    // plan settles on) does not depend on the thread count.
+    const size_t BLOCK = 1024;
+    std::vector<double> blockWires((mesh.faceCount() + BLOCK - 1) / BLOCK, 0.0);
+    ThreadPool::getInstance().parallelFor(blockWires.size(), [&](size_t firstBlock, size_t lastBlock) {
+        for (size_t block = firstBlock; block < lastBlock; ++block) {
+            size_t end = std::min(mesh.faceCount(), (block + 1) * BLOCK);
+            for (size_t f = block * BLOCK; f < end; ++f) {
+                Triangle triangle = mesh.triangle(f);
+                double h = spacing.spacingAt(triangle.center());
+                blockWires[block] += 2.0 * std::sqrt(3.0) * triangle.area() / (h * h);
+            }
+        }
+    });
+    double wires = 0.0;
+    for (double sum : blockWires) {
+        wires += sum;
+    }
+    wires += statistics.wireLength / spacing.getNearSpacing();
+    return static_cast<size_t>(std::ceil(wires));
+}
+
+size_t SegmentPlanner::countPathSegments(const std::vector<Point3D>& path, double spacing) {
+    size_t total = 0;
+    for (size_t i = 1; i < path.size(); ++i) {
+        int segments = std::max(1, static_cast<int>(std::ceil(path[i-1].distance(path[i]) / spacing)));
+        if (segments % 2 == 0) segments++;
+        total += segments;
+    }
+    return total;
+}
+
+double SegmentPlanner::matrixBytes(size_t segments) {
+    double n = static_cast<double>(segments);
+    return n * n * 16.0;
+}
+
+double SegmentPlanner::factorSeconds(size_t segments) const {
+    double n = static_cast<double>(segments);
+    return factorRate_ > 0.0 ? n * n * n / factorRate_ : 0.0;
+}
+
+SegmentPlan SegmentPlanner::plan(const MeshStatistics& statistics, const FrequencyCalculator& frequency,
+                                 size_t antennaSegments, bool highAccuracy) const {
+    SegmentPlan result;
+    result.antennaSegments = antennaSegments;
+
+    double requested = 0.1;
+    if (frequency.isValidFrequency()) {
+        requested = highAccuracy ? frequency.getHighAccuracyGridSpacing() : frequency.getStandardAccuracyGridSpacing();
+    }
+
+    double budget = segmentBudget();
+    double structureBudget = budget - static_cast<double>(antennaSegments);
+
+    result.gridSpacing = requested;
+    result.structureSegments = predictStructureSegments(statistics, requested);
+
+    if (static_cast<double>(result.structureSegments) > structureBudget) {
+        if (structureBudget >= 1.0) {
+            // Segments scale as 1/h^2, so solve for the spacing that just fits
+            result.gridSpacing = requested * std::sqrt(result.structureSegments / structureBudget);
+            result.structureSegments = predictStructureSegments(statistics, result.gridSpacing);
+            result.coarsened = true;
+        } else {
+            result.fitsBudget = false;
+        }
+    }
+
+    // Facets already coarser than half the pitch need no decimation
+    if (statistics.meanEdgeLength < result.gridSpacing / 2.0) {
+        result.decimationEdgeLength = result.gridSpacing / 2.0;
+    }
+
+    result.farSpacing = result.gridSpacing;
+    result.totalSegments = result.structureSegments + antennaSegments;
+    result.matrixBytes = matrixBytes(result.totalSegments);
+    result.factorSeconds = factorSeconds(result.totalSegments);
+    if (static_cast<double>(result.totalSegments) > budget + 1.0) {
+        result.fitsBudget = false;
+    }
+
+    return result;
+}
+
+SegmentPlan SegmentPlanner::plan(const IndexedMesh& mesh, const MeshStatistics& statistics, SpacingField& spacing,
+                                 size_t antennaSegments) const {
+    SegmentPlan result;
+    result.antennaSegments = antennaSegments;
+
+    double budget = segmentBudget();
+    double structureBudget = budget - static_cast<double>(antennaSegments);
+    result.structureSegments = predictStructureSegments(mesh, statistics, spacing);
+
+    if (static_cast<double>(result.structureSegments) > structureBudget) {
+        if (structureBudget >= 1.0) {
+            // Widening the pitch everywhere by k cuts the count by k^2
+            spacing.scale(std::sqrt(result.structureSegments / structureBudget));
+            result.structureSegments = predictStructureSegments(mesh, statistics, spacing);
+            result.coarsened = true;
+        } else {
+            result.fitsBudget = false;
+        }
+    }
+    result.gridSpacing = spacing.getNearSpacing();
+    result.farSpacing = spacing.getFarSpacing();
+
+    // Decimation must keep the detail the finest part of the grid needs
+    if (statistics.meanEdgeLength < result.gridSpacing / 2.0) {
+        result.decimationEdgeLength = result.gridSpacing / 2.0;
+    }
+
+    result.totalSegments = result.structureSegments + antennaSegments;
+    result.matrixBytes = matrixBytes(result.totalSegments);
+    result.factorSeconds = factorSeconds(result.totalSegments);
+    if (static_cast<double>(result.totalSegments) > budget + 1.0) {
+        result.fitsBudget = false;
+    }
+
+    return result;
+}
+
+bool SegmentPlanner::checkDeck(SegmentPlan& plan, size_t deckSegments) const {
+    plan.deckSegments = deckSegments;
+    plan.matrixBytes = matrixBytes(deckSegments);
+    plan.factorSeconds = factorSeconds(deckSegments);
+    plan.fitsBudget = static_cast<double>(deckSegments) <= segmentBudget() + 1.0;
+    return plan.fitsBudget;
+}
+
+bool SegmentPlanner::widen(SegmentPlan& plan, SpacingField& spacing) const {
+    double structureBudget = segmentBudget() - static_cast<double>(plan.antennaSegments);
+    double structure = static_cast<double>(plan.deckSegments) - static_cast<double>(plan.antennaSegments);
+    if (structureBudget < 1.0 || structure <= structureBudget) return false;
+
+    // Segments fall about as 1/h^2; the margin keeps the rebuild from landing just over
+    double factor = 1.05 * std::sqrt(structure / structureBudget);
+    spacing.scale(factor);
+    plan.gridSpacing = spacing.getNearSpacing();
+    plan.farSpacing = spacing.getFarSpacing();
+    if (plan.decimationEdgeLength > 0.0) {
+        plan.decimationEdgeLength = plan.gridSpacing / 2.0;
+    }
+    plan.coarsened = true;
+    return true;
+}
+
+double SegmentPlanner::segmentBudget() const {
+    double budget = static_cast<double>(maxSegments_);
+    if (targetSolveSeconds_ > 0.0 && factorRate_ > 0.0) {
+        budget = std::min(budget, std::cbrt(targetSolveSeconds_ * factorRate_));
+    }
+    return budget;
+}
+
+void SegmentPlanner::printPlan(const SegmentPlan& plan, const FrequencyCalculator& frequency) const {
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(1);
+    report << "\n=== Segment Budget ===\n";
+    report << "Grid spacing: " << plan.gridSpacing * 100.0 << " cm";
+    if (frequency.isValidFrequency()) {
+        report << " (λ/" << frequency.getWavelength() / plan.gridSpacing << ")";
+    }
+    if (plan.farSpacing > plan.gridSpacing) {
+        report << " near the antenna, growing to " << plan.farSpacing * 100.0 << " cm";
+        if (frequency.isValidFrequency()) {
+            report << " (λ/" << frequency.getWavelength() / plan.farSpacing << ")";
+        }
+    }
+    report << "\n";
+    if (plan.decimationEdgeLength > 0.0) {
+        report << "Decimation: edges shorter than " << plan.decimationEdgeLength * 100.0 << " cm\n";
+    }
+    report << "Predicted segments: " << plan.totalSegments << " (structure " << plan.structureSegments
+           << ", antenna " << plan.antennaSegments << "), limit " << maxSegments_ << "\n";
+    report << "Matrix memory: " << plan.matrixBytes / (1024.0 * 1024.0) << " MB\n";
+    report << "Factor time: " << plan.factorSeconds << " s (target " << targetSolveSeconds_ << " s)\n";
+
+    if (plan.coarsened) {
+        report << "WARNING: Grid spacing widened to fit the segment budget.\n";
+        if (frequency.isValidFrequency() && plan.farSpacing > frequency.getCoarseGridSpacing() * (1.0 + 1e-9)) {
+            report << "WARNING: Spacing exceeds λ/5; results will be approximate.\n";
+        }
+    }
+    if (!plan.fitsBudget) {
+        report << "WARNING: The antenna alone exceeds the segment budget.\n";
+    }
+    report << "\n";
+    std::cout << report.str();
+}
+
+void SegmentPlanner::printDeckCheck(const SegmentPlan& plan) const {
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(1);
+    report << "Deck segments: " << plan.deckSegments << " (predicted " << plan.totalSegments << ")\n";
+    report << "Matrix memory: " << plan.matrixBytes / (1024.0 * 1024.0) << " MB, factor time: "
+           << plan.factorSeconds << " s\n";
+    if (!plan.fitsBudget) {
+        report << "WARNING: The deck exceeds the segment budget.\n";
+    }
+    std::cout << report.str();
+}
+
+} // namespace stl_to_eznec
@@ -0,0 +1,60 @@
+#include "spacing_field.h"
+#include "mesh_bvh.h"
+#include <algorithm>
+#include <cmath>
+
+namespace stl_to_eznec {
+
+SpacingField::SpacingField(double spacing)
+    : nearSpacing_(spacing), farSpacing_(spacing), gradingDistance_(0) {
+}
+
+SpacingField::SpacingField(const IndexedMesh& sources, double nearSpacing, double farSpacing, double gradingDistance)
+    : nearSpacing_(nearSpacing), farSpacing_(std::max(nearSpacing, farSpacing)), gradingDistance_(gradingDistance) {
+    if (sources.faces.empty() || gradingDistance <= 0.0 || farSpacing_ <= nearSpacing_) {
+        farSpacing_ = nearSpacing_;
+        return;
+    }
+    // The tree keeps a pointer to its mesh, so both live behind shared pointers
+    sources_ = std::make_shared<const IndexedMesh>(sources);
+    bvh_ = std::make_shared<const MeshBVH>(*sources_);
+}
+
+SpacingField SpacingField::fromFrequency(const FrequencyCalculator& frequency, const IndexedMesh& antennas) {
+    if (!frequency.isValidFrequency()) {
+        return SpacingField();
+    }
+    return SpacingField(antennas, frequency.getHighAccuracyGridSpacing(), frequency.getCoarseGridSpacing(),
+                        frequency.getWavelength());
+}
+
+double SpacingField::spacingAt(const Point3D& point) const {
+    if (!bvh_) return nearSpacing_;
+
+    BVHHit hit = bvh_->nearest(point, gradingDistance_);
+    if (!hit.found()) return farSpacing_;
+    return nearSpacing_ + (farSpacing_ - nearSpacing_) * (hit.distance / gradingDistance_);
+}
+
+int SpacingField::segmentCount(const Point3D& start, const Point3D& end) const {
+    double length = start.distance(end);
+    if (length <= 0.0 || nearSpacing_ <= 0.0) return 1;
+    if (!bvh_) return std::max(1, static_cast<int>(std::ceil(length / nearSpacing_ - 1e-9)));
+
+    // Midpoint rule; the pitch changes slowly, so four samples per half grading distance suffice
+    int pieces = std::min(64, std::max(1, static_cast<int>(std::ceil(length / (0.5 * gradingDistance_)))) * 4);
+    double segments = 0.0;
+    for (int i = 0; i < pieces; ++i) {
+        Point3D p = start + (end - start) * ((i + 0.5) / pieces);
+        segments += (length / pieces) / spacingAt(p);
+    }
+    return std::max(1, static_cast<int>(std::ceil(segments - 1e-9)));
+}
+
+void SpacingField::scale(double factor) {
+    if (factor <= 0.0) return;
+    nearSpacing_ *= factor;
+    farSpacing_ *= factor;
+}
+
+} // namespace stl_to_eznec
@@ -0,0 +1,192 @@
+#include "surface_patcher.h"
+#include "surface_remesher.h"
+#include "mesh_bvh.h"
+#include "thread_pool.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace stl_to_eznec {
+
+namespace {
+
+uint64_t directedKey(uint32_t a, uint32_t b) {
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+void appendMesh(IndexedMesh& target, const IndexedMesh& source) {
+    uint32_t offset = static_cast<uint32_t>(target.vertices.size());
+    target.vertices.insert(target.vertices.end(), source.vertices.begin(), source.vertices.end());
+    for (const auto& face : source.faces) {
+        target.faces.push_back({face[0] + offset, face[1] + offset, face[2] + offset});
+    }
+}
+
+// Six times the signed volume; the mirror plane passes through the origin,
+// so the missing half of a clipped body adds nothing
+double signedVolume6(const IndexedMesh& mesh) {
+    double volume = 0.0;
+    for (const auto& face : mesh.faces) {
+        const Point3D& a = mesh.vertices[face[0]];
+        const Point3D& b = mesh.vertices[face[1]];
+        const Point3D& c = mesh.vertices[face[2]];
+        volume += a.x * (b.y * c.z - b.z * c.y) + a.y * (b.z * c.x - b.x * c.z) + a.z * (b.x * c.y - b.y * c.x);
+    }
+    return volume;
+}
+
+} // namespace
+
+SurfacePatcher::SurfacePatcher(double patchSize)
+    : patchSize_(patchSize), mirrorAxis_(-1) {
+}
+
+SurfacePatcher SurfacePatcher::fromFrequency(const FrequencyCalculator& frequency, double gridSpacing) {
+    if (!frequency.isValidFrequency()) {
+        return SurfacePatcher(gridSpacing);
+    }
+    return SurfacePatcher(std::max(gridSpacing, frequency.getCoarseGridSpacing()));
+}
+
+PatchSplit SurfacePatcher::split(const IndexedMesh& mesh, const SpacingField& wireSpacing,
+                                 const std::vector<Point3D>& attachments, double attachDistance,
+                                 PatchReport* report) const {
+    PatchReport local;
+    PatchReport& result = report ? *report : local;
+    result = PatchReport();
+
+    PatchSplit split;
+    if (mesh.faces.empty() || patchSize_ <= 0.0) {
+        split.wireMesh = mesh;
+        return split;
+    }
+
+    ComponentTable components = MeshTopology::findConnectedComponents(mesh);
+    result.components = components.size();
+
+    std::unordered_map<uint64_t, uint32_t> directed;
+    directed.reserve(mesh.faceCount() * 3);
+    for (const auto& face : mesh.faces) {
+        for (int i = 0; i < 3; ++i) {
+            directed[directedKey(face[i], face[(i + 1) % 3])]++;
+        }
+    }
+
+    auto onMirror = [this, &mesh](uint32_t v) {
+        if (mirrorAxis_ < 0) return false;
+        const Point3D& p = mesh.vertices[v];
+        return (mirrorAxis_ == 0 ? p.x : (mirrorAxis_ == 1 ? p.y : p.z)) == 0.0;
+    };
+
+    // Closed: each directed edge once, its reverse once (or never, on the seam)
+    std::vector<uint8_t> candidate(components.size(), 0);
+    ThreadPool::getInstance().parallelFor(components.size(), [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            bool closed = true;
+            for (uint32_t i = components.offsets[c]; i < components.offsets[c + 1] && closed; ++i) {
+                const auto& face = mesh.faces[components.faces[i]];
+                for (int k = 0; k < 3 && closed; ++k) {
+                    uint32_t a = face[k];
+                    uint32_t b = face[(k + 1) % 3];
+                    if (a == b || directed.find(directedKey(a, b))->second != 1) {
+                        closed = false;
+                        break;
+                    }
+                    auto reverse = directed.find(directedKey(b, a));
+                    if (reverse == directed.end()) {
+                        closed = onMirror(a) && onMirror(b);
+                    } else if (reverse->second != 1) {
+                        closed = false;
+                    }
+                }
+            }
+            candidate[c] = closed;
+        }
+    }, 16);
+    for (uint8_t closed : candidate) {
+        result.closedComponents += closed;
+    }
+
+    // Bodies a wire ends on stay wire grids
+    if (result.closedComponents > 0 && !attachments.empty()) {
+        MeshBVH bvh(mesh);
+        for (const auto& point : attachments) {
+            BVHHit hit = bvh.nearest(point, attachDistance);
+            if (!hit.found()) continue;
+            uint32_t c = components.faceComponent[hit.face];
+            if (candidate[c]) {
+                candidate[c] = 0;
+                result.attachedComponents++;
+            }
+        }
+    }
+
+    SurfaceRemesher remesher(patchSize_);
+    remesher.setMirrorPlane(mirrorAxis_);
+    SpacingField patchSpacing(patchSize_);
+
+    std::vector<uint8_t> patched(components.size(), 0);
+    std::vector<uint32_t> wireFaces;
+    for (size_t c = 0; c < components.size(); ++c) {
+        if (!candidate[c]) continue;
+
+        IndexedMesh body = MeshTopology::extractFaces(mesh, components.faces.data() + components.offsets[c],
+                                                      components.faces.data() + components.offsets[c + 1]);
+        double volume = signedVolume6(body);
+        if (std::abs(volume) <= 0.0) continue;
+        if (volume < 0.0) {
+            for (auto& face : body.faces) {
+                std::swap(face[1], face[2]);
+            }
+        }
+
+        IndexedMesh patches = remesher.remeshTriangles(body, patchSpacing);
+        if (patches.faceCount() < 4) continue;
+
+        // Wire-grid segments the body would need: 2*sqrt(3)*A / h^2 per facet
+        double segments = 0.0;
+        for (size_t f = 0; f < body.faceCount(); ++f) {
+            Triangle triangle = body.triangle(f);
+            double h = wireSpacing.spacingAt(triangle.center());
+            segments += 2.0 * std::sqrt(3.0) * triangle.area() / (h * h);
+        }
+        if (2.0 * patches.faceCount() >= segments) continue;
+
+        patched[c] = 1;
+        result.patchedComponents++;
+        result.patches += patches.faceCount();
+        result.replacedSegments += static_cast<size_t>(std::ceil(segments));
+        appendMesh(split.patchedMesh, body);
+        appendMesh(split.patches, patches);
+    }
+
+    if (result.patchedComponents == 0) {
+        split.wireMesh = mesh;
+        return split;
+    }
+    for (size_t c = 0; c < components.size(); ++c) {
+        if (patched[c]) continue;
+        wireFaces.insert(wireFaces.end(), components.faces.begin() + components.offsets[c],
+                         components.faces.begin() + components.offsets[c + 1]);
+    }
+    std::sort(wireFaces.begin(), wireFaces.end());
+    split.wireMesh = MeshTopology::extractFaces(mesh, wireFaces.data(), wireFaces.data() + wireFaces.size());
+    return split;
+}
+
+void SurfacePatcher::printReport(const PatchReport& report) {
+    std::cout << "\n=== Surface Patches ===\n";
+    std::cout << "Closed bodies: " << report.closedComponents << " of " << report.components << " components";
+    if (report.attachedComponents > 0) {
+        std::cout << " (" << report.attachedComponents << " with wires attached kept as wire grid)";
+    }
+    std::cout << "\n";
+    if (report.patchedComponents > 0) {
+        std::cout << "Written as NEC surface patches: " << report.patchedComponents << " bodies, " << report.patches
+                  << " patches (" << 2 * report.patches << " unknowns instead of about " << report.replacedSegments
+                  << " wire segments)\n";
+    }
+}
+
+} // namespace stl_to_eznec
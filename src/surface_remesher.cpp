@@ -0,0 +1,609 @@
+#include "surface_remesher.h"
+#include "planar_region_merger.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+namespace stl_to_eznec {
+
+namespace {
+
+uint64_t edgeKey(uint32_t a, uint32_t b) {
+    if (a > b) std::swap(a, b);
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+Point3D unitNormal(const IndexedMesh& mesh, const std::array<uint32_t, 3>& face) {
+    Point3D e1 = mesh.vertices[face[1]] - mesh.vertices[face[0]];
+    Point3D e2 = mesh.vertices[face[2]] - mesh.vertices[face[0]];
+    Point3D n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+    double length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+    return length > 0.0 ? n * (1.0 / length) : Point3D();
+}
+
+// Where a panel lattice line ends on an outline wire; t runs from the lower node id
+struct SplitPoint {
+    double t;
+    uint32_t node;
+};
+
+typedef std::unordered_map<uint64_t, std::vector<SplitPoint>> SplitMap;
+
+// Wires between two nodes, each stored once; seam-to-seam wires are dropped
+void addWire(std::vector<std::array<uint32_t, 2>>& edges, const std::vector<uint8_t>& onMirror,
+             uint32_t a, uint32_t b) {
+    if (a == b || (onMirror[a] && onMirror[b])) return;
+    edges.push_back({std::min(a, b), std::max(a, b)});
+}
+
+// Grid one planar panel. The outline is its boundary mapped to cluster
+// nodes; lattice lines of both directions are clipped to it with the
+// even-odd rule, join at shared lattice points and end on the outline wires,
+// which are split there. Returns false if the outline collapsed.
+bool gridPanel(const PlanarRegion& panel, const std::vector<uint32_t>& cluster, double pitch,
+               std::vector<Point3D>& points, std::vector<uint8_t>& onMirror,
+               std::vector<std::array<uint32_t, 2>>& edges, SplitMap& splits) {
+    struct Segment {
+        uint32_t a, b;
+        double u[2], v[2];
+    };
+
+    double uMin = std::numeric_limits<double>::infinity();
+    double uMax = -uMin;
+    double vMin = uMin;
+    double vMax = -uMin;
+    std::vector<Segment> outline;
+    outline.reserve(panel.boundary.size());
+    for (const auto& edge : panel.boundary) {
+        Segment segment;
+        segment.a = cluster[edge[0]];
+        segment.b = cluster[edge[1]];
+        if (segment.a == segment.b) continue;
+        for (int i = 0; i < 2; ++i) {
+            Point3D d = points[i == 0 ? segment.a : segment.b] - panel.origin;
+            segment.u[i] = d.x * panel.uAxis.x + d.y * panel.uAxis.y + d.z * panel.uAxis.z;
+            segment.v[i] = d.x * panel.vAxis.x + d.y * panel.vAxis.y + d.z * panel.vAxis.z;
+            uMin = std::min(uMin, segment.u[i]);
+            uMax = std::max(uMax, segment.u[i]);
+            vMin = std::min(vMin, segment.v[i]);
+            vMax = std::max(vMax, segment.v[i]);
+        }
+        outline.push_back(segment);
+    }
+    if (outline.size() < 3) return false;
+
+    // Lattice pitch divides the extent evenly and never exceeds the target
+    int uSteps = std::max(1, static_cast<int>(std::ceil((uMax - uMin) / pitch - 1e-9)));
+    int vSteps = std::max(1, static_cast<int>(std::ceil((vMax - vMin) / pitch - 1e-9)));
+    double uPitch = (uMax - uMin) / uSteps;
+    double vPitch = (vMax - vMin) / vSteps;
+    // Crossings and lattice points closer than this to a node merge with it
+    double snap = 0.3 * pitch;
+
+    std::unordered_map<uint64_t, uint32_t> lattice;
+    auto latticeNode = [&](int j, int k) {
+        uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(j)) << 32) | static_cast<uint32_t>(k);
+        auto inserted = lattice.emplace(key, static_cast<uint32_t>(points.size()));
+        if (inserted.second) {
+            points.push_back(panel.origin + panel.uAxis * (uMin + j * uPitch) + panel.vAxis * (vMin + k * vPitch));
+            onMirror.push_back(0);
+        }
+        return inserted.first->second;
+    };
+
+    // Crossings are shared with any other line (of this or a neighbouring
+    // panel) ending within the snap distance on the same outline wire
+    auto crossingNode = [&](size_t s, double t) {
+        const Segment& segment = outline[s];
+        double length = points[segment.a].distance(points[segment.b]);
+        if (t * length < snap) return segment.a;
+        if ((1.0 - t) * length < snap) return segment.b;
+
+        std::vector<SplitPoint>& along = splits[edgeKey(segment.a, segment.b)];
+        double key = segment.a < segment.b ? t : 1.0 - t;
+        for (const auto& point : along) {
+            if (std::abs(point.t - key) * length < snap) return point.node;
+        }
+        uint32_t node = static_cast<uint32_t>(points.size());
+        points.push_back(points[segment.a] + (points[segment.b] - points[segment.a]) * t);
+        onMirror.push_back(onMirror[segment.a] && onMirror[segment.b]);
+        along.push_back({key, node});
+        return node;
+    };
+
+    struct Crossing {
+        double along;
+        size_t segment;
+        double t;
+    };
+    std::vector<Crossing> crossings;
+
+    // Family 0 runs along u at constant v, family 1 along v at constant u
+    for (int family = 0; family < 2; ++family) {
+        int lines = family == 0 ? vSteps : uSteps;
+        int steps = family == 0 ? uSteps : vSteps;
+        double acrossMin = family == 0 ? vMin : uMin;
+        double acrossPitch = family == 0 ? vPitch : uPitch;
+        double alongMin = family == 0 ? uMin : vMin;
+        double alongPitch = family == 0 ? uPitch : vPitch;
+
+        for (int line = 1; line < lines; ++line) {
+            double c = acrossMin + line * acrossPitch;
+            crossings.clear();
+            for (size_t s = 0; s < outline.size(); ++s) {
+                const Segment& segment = outline[s];
+                const double* across = family == 0 ? segment.v : segment.u;
+                const double* along = family == 0 ? segment.u : segment.v;
+                if ((across[0] < c) == (across[1] < c)) continue;
+                double t = (c - across[0]) / (across[1] - across[0]);
+                crossings.push_back({along[0] + (along[1] - along[0]) * t, s, t});
+            }
+            // An open outline cannot be clipped against
+            if (crossings.size() % 2 != 0) continue;
+            std::sort(crossings.begin(), crossings.end(),
+                      [](const Crossing& a, const Crossing& b) { return a.along < b.along; });
+
+            for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+                const Crossing& enter = crossings[i];
+                const Crossing& leave = crossings[i + 1];
+                if (leave.along - enter.along < snap) continue;
+
+                uint32_t previous = crossingNode(enter.segment, enter.t);
+                uint32_t last = crossingNode(leave.segment, leave.t);
+                int first = std::max(1, static_cast<int>(std::ceil((enter.along + snap - alongMin) / alongPitch)));
+                for (int step = first; step < steps; ++step) {
+                    double along = alongMin + step * alongPitch;
+                    if (along >= leave.along - snap) break;
+                    uint32_t node = family == 0 ? latticeNode(step, line) : latticeNode(line, step);
+                    addWire(edges, onMirror, previous, node);
+                    previous = node;
+                }
+                addWire(edges, onMirror, previous, last);
+            }
+        }
+    }
+
+    for (const auto& segment : outline) {
+        addWire(edges, onMirror, segment.a, segment.b);
+    }
+    return true;
+}
+
+} // namespace
+
+SurfaceRemesher::SurfaceRemesher(double targetEdgeLength)
+    : targetEdgeLength_(targetEdgeLength), featureAngle_(30.0), panelAngle_(1.0), mirrorAxis_(-1),
+      groundPlane_(false) {
+}
+
+SurfaceRemesher SurfaceRemesher::fromFrequency(const FrequencyCalculator& frequency, bool highAccuracy) {
+    if (!frequency.isValidFrequency()) {
+        return SurfaceRemesher();
+    }
+    return SurfaceRemesher(highAccuracy ? frequency.getHighAccuracyGridSpacing()
+                                        : frequency.getStandardAccuracyGridSpacing());
+}
+
+WireGraph SurfaceRemesher::remesh(const std::vector<Triangle>& triangles) const {
+    return remesh(MeshTopology::buildIndexedMesh(triangles));
+}
+
+WireGraph SurfaceRemesher::remesh(const IndexedMesh& input) const {
+    return remesh(input, SpacingField(targetEdgeLength_));
+}
+
+WireGraph SurfaceRemesher::remesh(const IndexedMesh& input, const SpacingField& spacing) const {
+    WireGraph graph;
+    graph.segmentLength = spacing.getFarSpacing();
+    graph.mirrorAxis = mirrorAxis_;
+    double nearSpacing = spacing.getNearSpacing();
+    if (input.faces.empty() || nearSpacing <= 0.0) return graph;
+
+    std::vector<double> limits = bodyPitchLimits(input);
+    IndexedMesh mesh = refine(input, spacing, limits);
+    Clustering clustering = clusterVertices(mesh, spacing, limits);
+    const std::vector<uint32_t>& cluster = clustering.cluster;
+    std::vector<Point3D>& clusterPoints = clustering.points;
+    std::vector<uint8_t>& clusterOnMirror = clustering.onMirror;
+    const std::vector<int32_t>& vertexLevel = clustering.vertexLevel;
+    auto onMirror = [this](const Point3D& p) { return isOnSeam(p); };
+
+    std::vector<std::array<uint32_t, 2>> edges;
+    edges.reserve(mesh.faceCount() * 3 / 2);
+
+    // Coplanar panels are gridded on their own; a graded or clamped panel
+    // stays within one level so it has a single pitch
+    std::vector<uint8_t> inPanel(mesh.faceCount(), 0);
+    SplitMap splits;
+    if (panelAngle_ > 0.0) {
+        std::vector<int32_t> faceLevel;
+        if (!vertexLevel.empty()) {
+            faceLevel.resize(mesh.faceCount());
+            for (size_t f = 0; f < mesh.faceCount(); ++f) {
+                const auto& face = mesh.faces[f];
+                faceLevel[f] = std::min(vertexLevel[face[0]], std::min(vertexLevel[face[1]], vertexLevel[face[2]]));
+            }
+        }
+
+        PlanarRegionMerger merger(panelAngle_);
+        merger.setPlaneTolerance(0.01 * nearSpacing);
+        merger.setMinArea(4.0 * nearSpacing * nearSpacing);
+        for (const auto& panel : merger.merge(mesh, faceLevel)) {
+            // A panel in the mirror or ground plane is all seam
+            const auto& seed = mesh.faces[panel.faces.front()];
+            if (onMirror(mesh.vertices[seed[0]]) && onMirror(mesh.vertices[seed[1]]) &&
+                onMirror(mesh.vertices[seed[2]])) continue;
+
+            double pitch = std::ldexp(nearSpacing, faceLevel.empty() ? 0 : faceLevel[panel.faces.front()]);
+            if (panel.area < 4.0 * pitch * pitch) continue;
+            if (!gridPanel(panel, cluster, pitch, clusterPoints, clusterOnMirror, edges, splits)) continue;
+            for (uint32_t f : panel.faces) {
+                inPanel[f] = 1;
+            }
+        }
+    }
+
+    // Wires between distinct clusters, each stored once
+    for (size_t f = 0; f < mesh.faceCount(); ++f) {
+        if (inPanel[f]) continue;
+        const auto& face = mesh.faces[f];
+        for (int i = 0; i < 3; ++i) {
+            addWire(edges, clusterOnMirror, cluster[face[i]], cluster[face[(i + 1) % 3]]);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    // Outline wires end where the panel lattice meets them
+    if (!splits.empty()) {
+        std::vector<std::array<uint32_t, 2>> split;
+        split.reserve(edges.size() + splits.size() * 2);
+        for (const auto& edge : edges) {
+            auto it = splits.find(edgeKey(edge[0], edge[1]));
+            if (it == splits.end()) {
+                split.push_back(edge);
+                continue;
+            }
+            std::vector<SplitPoint>& along = it->second;
+            std::sort(along.begin(), along.end(), [](const SplitPoint& a, const SplitPoint& b) { return a.t < b.t; });
+            uint32_t previous = edge[0];
+            for (const auto& point : along) {
+                addWire(split, clusterOnMirror, previous, point.node);
+                previous = point.node;
+            }
+            addWire(split, clusterOnMirror, previous, edge[1]);
+        }
+        std::sort(split.begin(), split.end());
+        split.erase(std::unique(split.begin(), split.end()), split.end());
+        edges = std::move(split);
+    }
+
+    // Keep only nodes that carry a wire
+    std::vector<uint32_t> remap(clusterPoints.size(), 0xFFFFFFFFu);
+    for (auto& edge : edges) {
+        for (auto& node : edge) {
+            if (remap[node] == 0xFFFFFFFFu) {
+                remap[node] = static_cast<uint32_t>(graph.nodes.size());
+                graph.nodes.push_back(clusterPoints[node]);
+            }
+            node = remap[node];
+        }
+        if (edge[0] > edge[1]) std::swap(edge[0], edge[1]);
+    }
+    graph.edges = std::move(edges);
+
+    return graph;
+}
+
+IndexedMesh SurfaceRemesher::remeshTriangles(const IndexedMesh& input, const SpacingField& spacing) const {
+    IndexedMesh result;
+    if (input.faces.empty() || spacing.getNearSpacing() <= 0.0) return result;
+
+    std::vector<double> limits = bodyPitchLimits(input);
+    IndexedMesh mesh = refine(input, spacing, limits);
+    Clustering clustering = clusterVertices(mesh, spacing, limits);
+
+    // Facets spanning three nodes; of several on the same nodes the first is kept
+    struct FaceKey {
+        std::array<uint32_t, 3> nodes;
+        uint32_t face;
+    };
+    std::vector<FaceKey> keys;
+    keys.reserve(mesh.faceCount() / 2);
+    for (uint32_t f = 0; f < mesh.faceCount(); ++f) {
+        std::array<uint32_t, 3> nodes;
+        for (int i = 0; i < 3; ++i) {
+            nodes[i] = clustering.cluster[mesh.faces[f][i]];
+        }
+        if (nodes[0] == nodes[1] || nodes[1] == nodes[2] || nodes[0] == nodes[2]) continue;
+        if (clustering.onMirror[nodes[0]] && clustering.onMirror[nodes[1]] && clustering.onMirror[nodes[2]]) continue;
+        std::sort(nodes.begin(), nodes.end());
+        keys.push_back({nodes, f});
+    }
+    std::sort(keys.begin(), keys.end(), [](const FaceKey& a, const FaceKey& b) {
+        return a.nodes != b.nodes ? a.nodes < b.nodes : a.face < b.face;
+    });
+
+    std::vector<uint32_t> kept;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (i == 0 || keys[i].nodes != keys[i - 1].nodes) kept.push_back(keys[i].face);
+    }
+    std::sort(kept.begin(), kept.end());
+
+    IndexedMesh clustered;
+    clustered.vertices = std::move(clustering.points);
+    clustered.faces.reserve(kept.size());
+    for (uint32_t f : kept) {
+        const auto& face = mesh.faces[f];
+        clustered.faces.push_back({clustering.cluster[face[0]], clustering.cluster[face[1]], clustering.cluster[face[2]]});
+    }
+    for (uint32_t f = 0; f < clustered.faceCount(); ++f) {
+        kept[f] = f;
+    }
+    return MeshTopology::extractFaces(clustered, kept.data(), kept.data() + kept.size());
+}
+
+SurfaceRemesher::Clustering SurfaceRemesher::clusterVertices(const IndexedMesh& mesh, const SpacingField& spacing,
+                                                             const std::vector<double>& limits) const {
+    Clustering result;
+    double nearSpacing = spacing.getNearSpacing();
+    std::vector<uint32_t> degree = featureDegrees(mesh, featureAngle_);
+
+    // Group vertices by grid cell; graded fields use a coarser grid
+    // (level L = pitch near * 2^L) where the local pitch allows, and small
+    // bodies a finer one (negative L)
+    struct CellVertex {
+        int32_t level;
+        int64_t ix, iy, iz;
+        uint8_t seam;
+        uint32_t vertex;
+    };
+    std::vector<CellVertex> cells(mesh.vertexCount());
+    ThreadPool::getInstance().parallelFor(mesh.vertexCount(), [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            const Point3D& p = mesh.vertices[v];
+            int32_t level = 0;
+            if (spacing.isGraded()) {
+                level = static_cast<int32_t>(std::floor(std::log2(spacing.spacingAt(p) / nearSpacing) + 1e-9));
+                level = std::max(0, level);
+            }
+            if (limits[v] < std::ldexp(nearSpacing, level)) {
+                level = static_cast<int32_t>(std::floor(std::log2(limits[v] / nearSpacing) + 1e-9));
+            }
+            double cell = std::ldexp(nearSpacing, level);
+            cells[v] = {level,
+                        static_cast<int64_t>(std::floor(p.x / cell)),
+                        static_cast<int64_t>(std::floor(p.y / cell)),
+                        static_cast<int64_t>(std::floor(p.z / cell)), static_cast<uint8_t>(isOnSeam(p) ? 1 : 0),
+                        static_cast<uint32_t>(v)};
+        }
+    }, 4096);
+    bool leveled = false;
+    for (const auto& cell : cells) {
+        if (cell.level != 0) {
+            leveled = true;
+            break;
+        }
+    }
+    if (leveled) {
+        result.vertexLevel.resize(cells.size());
+        for (const auto& cell : cells) {
+            result.vertexLevel[cell.vertex] = cell.level;
+        }
+    }
+    std::sort(cells.begin(), cells.end(), [](const CellVertex& a, const CellVertex& b) {
+        if (a.level != b.level) return a.level < b.level;
+        if (a.ix != b.ix) return a.ix < b.ix;
+        if (a.iy != b.iy) return a.iy < b.iy;
+        if (a.iz != b.iz) return a.iz < b.iz;
+        if (a.seam != b.seam) return a.seam < b.seam;
+        return a.vertex < b.vertex;
+    });
+
+    // Corners (feature degree 1 or >= 3) beat feature-line vertices, which
+    // beat smooth ones. A smooth cell's node is the mean of its vertices;
+    // any other cell's node is the top-ranked vertex nearest their mean, so
+    // outlines and creases stay on the surface rather than being averaged
+    // into the body. Seam vertices (mirror or ground plane) cluster apart
+    // from the rest of their cell, so a seam node never swallows the
+    // vertices just off the plane and the wires to them survive.
+    auto rank = [&degree](uint32_t v) {
+        return degree[v] == 0 ? 0 : (degree[v] == 2 ? 1 : 2);
+    };
+
+    result.cluster.resize(mesh.vertexCount());
+    for (size_t begin = 0; begin < cells.size();) {
+        size_t end = begin + 1;
+        while (end < cells.size() && cells[end].level == cells[begin].level && cells[end].ix == cells[begin].ix &&
+               cells[end].iy == cells[begin].iy && cells[end].iz == cells[begin].iz &&
+               cells[end].seam == cells[begin].seam) {
+            ++end;
+        }
+
+        int best = 0;
+        for (size_t i = begin; i < end; ++i) {
+            best = std::max(best, rank(cells[i].vertex));
+        }
+
+        Point3D sum(0, 0, 0);
+        int count = 0;
+        uint32_t id = static_cast<uint32_t>(result.points.size());
+        result.onMirror.push_back(cells[begin].seam);
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t v = cells[i].vertex;
+            result.cluster[v] = id;
+            if (rank(v) == best) {
+                sum = sum + mesh.vertices[v];
+                count++;
+            }
+        }
+        Point3D mean = sum * (1.0 / count);
+        if (best > 0) {
+            double nearest = std::numeric_limits<double>::infinity();
+            Point3D snapped = mean;
+            for (size_t i = begin; i < end; ++i) {
+                uint32_t v = cells[i].vertex;
+                double distance = mesh.vertices[v].distance(mean);
+                if (rank(v) == best && distance < nearest) {
+                    nearest = distance;
+                    snapped = mesh.vertices[v];
+                }
+            }
+            mean = snapped;
+        }
+        result.points.push_back(mean);
+        begin = end;
+    }
+    return result;
+}
+
+IndexedMesh SurfaceRemesher::refine(const IndexedMesh& input, double maxLength) {
+    return refine(input, SpacingField(maxLength));
+}
+
+IndexedMesh SurfaceRemesher::refine(const IndexedMesh& input, const SpacingField& spacing) {
+    std::vector<double> limits(input.vertexCount(), std::numeric_limits<double>::infinity());
+    return refine(input, spacing, limits);
+}
+
+IndexedMesh SurfaceRemesher::refine(const IndexedMesh& input, const SpacingField& spacing, std::vector<double>& limits) {
+    IndexedMesh mesh = input;
+    if (spacing.getNearSpacing() <= 0.0) return mesh;
+
+    // Pitch at every vertex, extended as midpoints are added
+    std::vector<double> vertexSpacing(mesh.vertexCount(), spacing.getNearSpacing());
+    ThreadPool::getInstance().parallelFor(mesh.vertexCount(), [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            if (spacing.isGraded()) {
+                vertexSpacing[v] = spacing.spacingAt(mesh.vertices[v]);
+            }
+            vertexSpacing[v] = std::min(vertexSpacing[v], limits[v]);
+        }
+    }, 4096);
+
+    std::unordered_map<uint64_t, uint32_t> midpoints;
+    std::vector<uint32_t> pending(mesh.faceCount());
+    for (uint32_t f = 0; f < pending.size(); ++f) {
+        pending[f] = f;
+    }
+
+    // Bisecting the longest edge only ever splits edges longer than the pitch
+    // at their ends, and both faces sharing such an edge split it at the same
+    // cached midpoint, so the refined mesh stays conforming
+    while (!pending.empty()) {
+        uint32_t f = pending.back();
+        pending.pop_back();
+
+        std::array<uint32_t, 3> face = mesh.faces[f];
+        int longest = -1;
+        double longestSquared = 0.0;
+        for (int i = 0; i < 3; ++i) {
+            Point3D d = mesh.vertices[face[(i + 1) % 3]] - mesh.vertices[face[i]];
+            double lengthSquared = d.x * d.x + d.y * d.y + d.z * d.z;
+            double maxLength = std::min(vertexSpacing[face[i]], vertexSpacing[face[(i + 1) % 3]]);
+            if (lengthSquared > maxLength * maxLength && lengthSquared > longestSquared) {
+                longestSquared = lengthSquared;
+                longest = i;
+            }
+        }
+        if (longest < 0) continue;
+
+        uint32_t a = face[longest];
+        uint32_t b = face[(longest + 1) % 3];
+        uint32_t c = face[(longest + 2) % 3];
+
+        auto inserted = midpoints.emplace(edgeKey(a, b), static_cast<uint32_t>(mesh.vertices.size()));
+        if (inserted.second) {
+            mesh.vertices.push_back((mesh.vertices[a] + mesh.vertices[b]) * 0.5);
+            limits.push_back(std::min(limits[a], limits[b]));
+            double pitch = spacing.isGraded() ? spacing.spacingAt(mesh.vertices.back()) : spacing.getNearSpacing();
+            vertexSpacing.push_back(std::min(pitch, limits.back()));
+        }
+        uint32_t m = inserted.first->second;
+
+        mesh.faces[f] = {a, m, c};
+        mesh.faces.push_back({m, b, c});
+        pending.push_back(f);
+        pending.push_back(static_cast<uint32_t>(mesh.faces.size() - 1));
+    }
+
+    return mesh;
+}
+
+std::vector<uint32_t> SurfaceRemesher::featureDegrees(const IndexedMesh& mesh, double featureAngleDegrees) {
+    struct EdgeUse {
+        uint32_t faces;
+        uint32_t firstFace;
+        bool sharp;
+    };
+
+    double cosLimit = std::cos(featureAngleDegrees * M_PI / 180.0);
+    std::vector<Point3D> normals(mesh.faceCount());
+    for (size_t f = 0; f < mesh.faceCount(); ++f) {
+        normals[f] = unitNormal(mesh, mesh.faces[f]);
+    }
+
+    std::unordered_map<uint64_t, EdgeUse> uses;
+    uses.reserve(mesh.faceCount() * 3 / 2);
+    for (uint32_t f = 0; f < mesh.faceCount(); ++f) {
+        const auto& face = mesh.faces[f];
+        // Faces welded down to a sliver or a point have no edges of their own
+        if (face[0] == face[1] || face[1] == face[2] || face[0] == face[2]) continue;
+
+        for (int i = 0; i < 3; ++i) {
+            auto inserted = uses.emplace(edgeKey(face[i], face[(i + 1) % 3]), EdgeUse{1, f, false});
+            if (inserted.second) continue;
+
+            EdgeUse& use = inserted.first->second;
+            use.faces++;
+            const Point3D& n1 = normals[use.firstFace];
+            const Point3D& n2 = normals[f];
+            if (n1.x * n2.x + n1.y * n2.y + n1.z * n2.z < cosLimit) {
+                use.sharp = true;
+            }
+        }
+    }
+
+    std::vector<uint32_t> degree(mesh.vertexCount(), 0);
+    for (const auto& entry : uses) {
+        const EdgeUse& use = entry.second;
+        // Open (one face) and non-manifold (three or more) edges are features too
+        if (use.sharp || use.faces != 2) {
+            degree[static_cast<uint32_t>(entry.first >> 32)]++;
+            degree[static_cast<uint32_t>(entry.first & 0xFFFFFFFFu)]++;
+        }
+    }
+    return degree;
+}
+
+std::vector<double> SurfaceRemesher::bodyPitchLimits(const IndexedMesh& mesh) {
+    std::vector<double> limits(mesh.vertexCount(), std::numeric_limits<double>::infinity());
+    ComponentTable components = MeshTopology::findConnectedComponents(mesh);
+    ThreadPool::getInstance().parallelFor(components.size(), [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            const Point3D& first = mesh.vertices[mesh.faces[components.faces[components.offsets[c]]][0]];
+            Point3D low = first;
+            Point3D high = first;
+            for (uint32_t i = components.offsets[c]; i < components.offsets[c + 1]; ++i) {
+                for (uint32_t v : mesh.faces[components.faces[i]]) {
+                    const Point3D& p = mesh.vertices[v];
+                    low = Point3D(std::min(low.x, p.x), std::min(low.y, p.y), std::min(low.z, p.z));
+                    high = Point3D(std::max(high.x, p.x), std::max(high.y, p.y), std::max(high.z, p.z));
+                }
+            }
+            double limit = 0.5 * std::max(high.x - low.x, std::max(high.y - low.y, high.z - low.z));
+            if (limit <= 0.0) continue;
+            // Components share no vertices, so each writes its own entries
+            for (uint32_t i = components.offsets[c]; i < components.offsets[c + 1]; ++i) {
+                for (uint32_t v : mesh.faces[components.faces[i]]) {
+                    limits[v] = limit;
+                }
+            }
+        }
+    });
+    return limits;
+}
+
+} // namespace stl_to_eznec
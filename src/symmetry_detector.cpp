@@ -0,0 +1,106 @@
+#include "symmetry_detector.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace stl_to_eznec {
+
+namespace {
+
+double coordinate(const Point3D& p, int axis) {
+    return axis == 0 ? p.x : (axis == 1 ? p.y : p.z);
+}
+
+Point3D mirrored(Point3D p, int axis) {
+    (axis == 0 ? p.x : (axis == 1 ? p.y : p.z)) = -coordinate(p, axis);
+    return p;
+}
+
+} // namespace
+
+SymmetryDetector::SymmetryDetector()
+    : tolerance_(1e-3), minMatchFraction_(0.97), maxInPlaneFraction_(0.01) {
+}
+
+SymmetryPlane SymmetryDetector::evaluate(const IndexedMesh& mesh, int axis) const {
+    SymmetryPlane plane;
+    if (mesh.vertices.empty() || mesh.faces.empty()) return plane;
+
+    Point3D low = mesh.vertices[0];
+    Point3D high = mesh.vertices[0];
+    for (const auto& v : mesh.vertices) {
+        low = Point3D(std::min(low.x, v.x), std::min(low.y, v.y), std::min(low.z, v.z));
+        high = Point3D(std::max(high.x, v.x), std::max(high.y, v.y), std::max(high.z, v.z));
+    }
+    double diagonal = low.distance(high);
+    if (diagonal <= 0.0) return plane;
+    double tolerance = tolerance_ * diagonal;
+
+    // A mirror image can only match if the extent is centred on the plane
+    if (std::abs(coordinate(low, axis) + coordinate(high, axis)) > 2.0 * tolerance) return plane;
+
+    SpatialHash hash(tolerance);
+    hash.reserve(mesh.vertexCount());
+    for (uint32_t v = 0; v < mesh.vertexCount(); ++v) {
+        hash.insert(mesh.vertices[v], v);
+    }
+
+    // Lookups only read the hash, so chunks run concurrently
+    std::atomic<size_t> matched(0);
+    ThreadPool::getInstance().parallelFor(mesh.vertexCount(), [&](size_t begin, size_t end) {
+        size_t local = 0;
+        for (size_t v = begin; v < end; ++v) {
+            if (hash.findNear(mirrored(mesh.vertices[v], axis), tolerance) >= 0) local++;
+        }
+        matched += local;
+    }, 4096);
+
+    double totalArea = 0.0;
+    double inPlaneArea = 0.0;
+    for (size_t f = 0; f < mesh.faceCount(); ++f) {
+        double area = mesh.triangle(f).area();
+        totalArea += area;
+        const auto& face = mesh.faces[f];
+        if (std::abs(coordinate(mesh.vertices[face[0]], axis)) <= tolerance &&
+            std::abs(coordinate(mesh.vertices[face[1]], axis)) <= tolerance &&
+            std::abs(coordinate(mesh.vertices[face[2]], axis)) <= tolerance) {
+            inPlaneArea += area;
+        }
+    }
+
+    plane.axis = axis;
+    plane.matchFraction = static_cast<double>(matched.load()) / mesh.vertexCount();
+    plane.inPlaneAreaFraction = totalArea > 0.0 ? inPlaneArea / totalArea : 0.0;
+    return plane;
+}
+
+SymmetryPlane SymmetryDetector::detect(const IndexedMesh& mesh) const {
+    SymmetryPlane best;
+    for (int axis = 0; axis < 2; ++axis) {
+        SymmetryPlane candidate = evaluate(mesh, axis);
+        if (!candidate.found()) continue;
+        if (candidate.matchFraction < minMatchFraction_) continue;
+        if (candidate.inPlaneAreaFraction > maxInPlaneFraction_) continue;
+        if (!best.found() || candidate.matchFraction > best.matchFraction) {
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+IndexedMesh SymmetryDetector::keepHalf(const IndexedMesh& mesh, const SymmetryPlane& plane) {
+    if (!plane.found()) return mesh;
+    return MeshTopology::clipToHalfSpace(mesh, plane.axis, 0.0);
+}
+
+double SymmetryDetector::halfExtent(const IndexedMesh& mesh, const SymmetryPlane& plane) {
+    double extent = 0.0;
+    if (!plane.found()) return extent;
+    for (const auto& vertex : mesh.vertices) {
+        extent = std::max(extent, coordinate(vertex, plane.axis));
+    }
+    return extent;
+}
+
+} // namespace stl_to_eznec
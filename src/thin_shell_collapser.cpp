@@ -0,0 +1,265 @@
+#include "thin_shell_collapser.h"
+#include "mesh_bvh.h"
+#include "thread_pool.h"
+#include "covariance_accumulator.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+namespace stl_to_eznec {
+
+namespace {
+
+const uint32_t NONE = 0xFFFFFFFFu;
+
+Point3D cross(const Point3D& a, const Point3D& b) {
+    return Point3D(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+double dot(const Point3D& a, const Point3D& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+uint32_t findRoot(std::vector<uint32_t>& parent, uint32_t node) {
+    while (parent[node] != node) {
+        parent[node] = parent[parent[node]];
+        node = parent[node];
+    }
+    return node;
+}
+
+} // namespace
+
+ThinShellCollapser::ThinShellCollapser(double maxThickness)
+    : maxThickness_(maxThickness), maxThicknessToWidth_(0.1), opposingCosine_(0.9) {
+}
+
+ThinShellCollapser ThinShellCollapser::fromFrequency(const FrequencyCalculator& frequency, double divisions) {
+    if (!frequency.isValidFrequency() || divisions <= 0.0) {
+        return ThinShellCollapser();
+    }
+    return ThinShellCollapser(frequency.getWavelength() / divisions);
+}
+
+IndexedMesh ThinShellCollapser::collapse(const IndexedMesh& mesh, ThinShellReport* report) const {
+    ThinShellReport local;
+    ThinShellReport& result = report ? *report : local;
+    result = ThinShellReport();
+    result.inputFacets = mesh.faceCount();
+    if (mesh.faces.empty() || maxThickness_ <= 0.0) return mesh;
+
+    ThreadPool& pool = ThreadPool::getInstance();
+    size_t faceCount = mesh.faceCount();
+
+    // Unit normals, twice the facet areas and the signed volume
+    std::vector<Point3D> normals(faceCount);
+    std::vector<double> areas(faceCount);
+    double volume = 0.0;
+    for (size_t f = 0; f < faceCount; ++f) {
+        const auto& face = mesh.faces[f];
+        const Point3D& a = mesh.vertices[face[0]];
+        Point3D n = cross(mesh.vertices[face[1]] - a, mesh.vertices[face[2]] - a);
+        double length = std::sqrt(dot(n, n));
+        areas[f] = length;
+        normals[f] = length > 0.0 ? n * (1.0 / length) : Point3D();
+        volume += dot(a, cross(mesh.vertices[face[1]], mesh.vertices[face[2]]));
+    }
+    // Rays go into the material; an inside-out mesh is wound the other way
+    double inward = volume >= 0.0 ? -1.0 : 1.0;
+
+    // Nearest facet straight through the wall, kept if it faces the other way
+    MeshBVH bvh(mesh);
+    std::vector<uint32_t> partner(faceCount, NONE);
+    std::vector<double> thickness(faceCount, 0.0);
+    pool.parallelFor(faceCount, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            if (areas[f] <= 0.0) continue;
+            const auto& face = mesh.faces[f];
+            Point3D centroid = (mesh.vertices[face[0]] + mesh.vertices[face[1]] + mesh.vertices[face[2]]) * (1.0 / 3.0);
+            BVHHit hit = bvh.intersect(centroid, normals[f] * inward, maxThickness_, static_cast<int64_t>(f));
+            if (hit.found() && dot(normals[f], normals[hit.face]) <= -opposingCosine_) {
+                partner[f] = static_cast<uint32_t>(hit.face);
+                thickness[f] = hit.distance;
+            }
+        }
+    }, 256);
+
+    // Sheets: paired facets joined across edges that do not fold back
+    std::vector<uint32_t> parent(faceCount);
+    std::iota(parent.begin(), parent.end(), 0u);
+    std::unordered_map<uint64_t, uint32_t> edgeOwner;
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        if (partner[f] == NONE) continue;
+        result.pairedFacets++;
+        const auto& face = mesh.faces[f];
+        for (int i = 0; i < 3; ++i) {
+            uint32_t a = face[i], b = face[(i + 1) % 3];
+            uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+            auto owner = edgeOwner.emplace(key, f);
+            if (owner.second || dot(normals[f], normals[owner.first->second]) < 0.5) continue;
+            uint32_t rootA = findRoot(parent, f);
+            uint32_t rootB = findRoot(parent, owner.first->second);
+            if (rootA != rootB) parent[std::max(rootA, rootB)] = std::min(rootA, rootB);
+        }
+    }
+    if (result.pairedFacets == 0) {
+        result.outputFacets = faceCount;
+        return mesh;
+    }
+
+    std::vector<uint32_t> sheet(faceCount, NONE);
+    std::vector<uint32_t> rootSheet(faceCount, NONE);
+    std::vector<double> sheetArea;
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        if (partner[f] == NONE) continue;
+        uint32_t root = findRoot(parent, f);
+        if (rootSheet[root] == NONE) {
+            rootSheet[root] = static_cast<uint32_t>(sheetArea.size());
+            sheetArea.push_back(0.0);
+        }
+        sheet[f] = rootSheet[root];
+        sheetArea[sheet[f]] += areas[f];
+    }
+    size_t sheetCount = sheetArea.size();
+    result.skins = sheetCount;
+
+    // Area-weighted thickness and in-plane width (second principal extent) of every sheet
+    std::vector<double> sheetThickness(sheetCount, 0.0);
+    std::vector<CovarianceAccumulator> sheetMoments(sheetCount);
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        if (sheet[f] == NONE) continue;
+        const auto& face = mesh.faces[f];
+        sheetThickness[sheet[f]] += thickness[f] * areas[f];
+        sheetMoments[sheet[f]].addTriangle(mesh.vertices[face[0]], mesh.vertices[face[1]], mesh.vertices[face[2]]);
+    }
+    std::vector<double> sheetWidth(sheetCount, 0.0);
+    pool.parallelFor(sheetCount, [&](size_t begin, size_t end) {
+        for (size_t s = begin; s < end; ++s) {
+            sheetThickness[s] /= sheetArea[s];
+            sheetWidth[s] = sheetMoments[s].getOrientedExtents().extents[1];
+        }
+    });
+
+    // The sheet most facets of each sheet pair with
+    std::unordered_map<uint64_t, uint32_t> votes;
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        if (sheet[f] == NONE || sheet[partner[f]] == NONE || sheet[partner[f]] == sheet[f]) continue;
+        votes[(static_cast<uint64_t>(sheet[f]) << 32) | sheet[partner[f]]]++;
+    }
+    std::vector<uint32_t> opposite(sheetCount, NONE);
+    std::vector<uint32_t> bestVotes(sheetCount, 0);
+    for (const auto& entry : votes) {
+        uint32_t s = static_cast<uint32_t>(entry.first >> 32);
+        uint32_t other = static_cast<uint32_t>(entry.first & NONE);
+        if (entry.second > bestVotes[s] || (entry.second == bestVotes[s] && other < opposite[s])) {
+            bestVotes[s] = entry.second;
+            opposite[s] = other;
+        }
+    }
+
+    // Largest sheets first: a sheet is dropped when its opposite is already kept
+    enum SheetState : uint8_t { UNDECIDED, KEPT, COLLAPSED, DROPPED };
+    std::vector<uint32_t> order(sheetCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&sheetArea](uint32_t a, uint32_t b) {
+        return sheetArea[a] > sheetArea[b];
+    });
+    std::vector<uint8_t> state(sheetCount, UNDECIDED);
+    for (uint32_t s : order) {
+        uint32_t other = opposite[s];
+        if (other != NONE && (state[other] == KEPT || state[other] == COLLAPSED)) {
+            double width = std::min(sheetWidth[s], sheetWidth[other]);
+            if (std::max(sheetThickness[s], sheetThickness[other]) <= maxThicknessToWidth_ * width) {
+                state[s] = DROPPED;
+                state[other] = COLLAPSED;
+                continue;
+            }
+            result.thickSkins++;
+        }
+        state[s] = KEPT;
+    }
+    for (uint8_t s : state) {
+        if (s == COLLAPSED) result.collapsedSkins++;
+    }
+
+    // Mid-surface offset per vertex, averaged over the collapsed facets around it
+    enum VertexState : uint8_t { FREE, ON_COLLAPSED, ON_DROPPED };
+    std::vector<uint8_t> vertexState(mesh.vertexCount(), FREE);
+    std::vector<Point3D> offset(mesh.vertexCount());
+    std::vector<uint32_t> offsetCount(mesh.vertexCount(), 0);
+    size_t collapsedFacets = 0;
+    double thicknessSum = 0.0;
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        if (sheet[f] == NONE) continue;
+        uint8_t s = state[sheet[f]];
+        if (s == DROPPED) {
+            for (uint32_t v : mesh.faces[f]) {
+                if (vertexState[v] == FREE) vertexState[v] = ON_DROPPED;
+            }
+        } else if (s == COLLAPSED) {
+            bool acrossDropped = sheet[partner[f]] != NONE && state[sheet[partner[f]]] == DROPPED;
+            Point3D shift = normals[f] * (inward * 0.5 * thickness[f]);
+            for (uint32_t v : mesh.faces[f]) {
+                vertexState[v] = ON_COLLAPSED;
+                if (!acrossDropped) continue;
+                offset[v] = offset[v] + shift;
+                offsetCount[v]++;
+            }
+            if (acrossDropped) {
+                collapsedFacets++;
+                thicknessSum += thickness[f];
+            }
+        }
+    }
+    if (collapsedFacets > 0) result.meanThickness = thicknessSum / collapsedFacets;
+
+    // Drop the opposing skins and any facet bridging only the two skins (the rims)
+    std::vector<uint32_t> kept;
+    kept.reserve(faceCount);
+    for (uint32_t f = 0; f < faceCount; ++f) {
+        if (sheet[f] != NONE && state[sheet[f]] == DROPPED) continue;
+        bool touchesFree = false;
+        bool touchesDropped = false;
+        for (uint32_t v : mesh.faces[f]) {
+            touchesFree |= vertexState[v] == FREE;
+            touchesDropped |= vertexState[v] == ON_DROPPED;
+        }
+        if (touchesDropped && !touchesFree) continue;
+        kept.push_back(f);
+    }
+    result.removedFacets = faceCount - kept.size();
+
+    IndexedMesh moved = mesh;
+    pool.parallelFor(moved.vertexCount(), [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            if (offsetCount[v] > 0) {
+                moved.vertices[v] = moved.vertices[v] + offset[v] * (1.0 / offsetCount[v]);
+            }
+        }
+    }, 8192);
+
+    IndexedMesh collapsed = MeshTopology::extractFaces(moved, kept.data(), kept.data() + kept.size());
+    result.outputFacets = collapsed.faceCount();
+    return collapsed;
+}
+
+void ThinShellCollapser::printReport(const ThinShellReport& report) {
+    std::ostringstream text;
+    text << "\n=== Double Skins ===\n";
+    text << "Paired facets: " << report.pairedFacets << " in " << report.skins << " skins\n";
+    if (report.collapsedSkins > 0) {
+        text << "Skins collapsed to a mid-surface: " << report.collapsedSkins << " (mean thickness "
+             << std::fixed << std::setprecision(1) << report.meanThickness * 1000.0 << " mm)\n";
+    }
+    if (report.thickSkins > 0) {
+        text << "Skins kept as too thick for their width: " << report.thickSkins << "\n";
+    }
+    text << "Facets: " << report.inputFacets << " -> " << report.outputFacets << "\n";
+    std::cout << text.str();
+}
+
+} // namespace stl_to_eznec
@@ -0,0 +1,77 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+namespace stl_to_eznec {
+
+ThreadPool::ThreadPool(unsigned threadCount)
+    : stopping_(false) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers_.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::getInstance() {
+    static ThreadPool instance;
+    return instance;
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (stopping_ && tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, size_t)>& body, size_t minChunk) {
+    if (count == 0) return;
+
+    size_t chunkCount = std::min<size_t>(getThreadCount() * 4, (count + minChunk - 1) / std::max<size_t>(minChunk, 1));
+    chunkCount = std::max<size_t>(chunkCount, 1);
+
+    if (chunkCount == 1) {
+        body(0, count);
+        return;
+    }
+
+    std::vector<std::future<void>> pending;
+    pending.reserve(chunkCount);
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+        size_t begin = count * chunk / chunkCount;
+        size_t end = count * (chunk + 1) / chunkCount;
+        pending.push_back(submit([&body, begin, end]() { body(begin, end); }));
+    }
+
+    // Wait for every chunk before rethrowing, since tasks reference body
+    for (auto& future : pending) {
+        future.wait();
+    }
+    for (auto& future : pending) {
+        future.get();
+    }
+}
+
+} // namespace stl_to_eznec
@@ -0,0 +1,177 @@
+#include "tube_collapser.h"
+#include "antenna_detector.h"
+#include "thread_pool.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+namespace stl_to_eznec {
+
+namespace {
+
+double axisValue(const Point3D& p, int axis) {
+    return axis == 0 ? p.x : (axis == 1 ? p.y : p.z);
+}
+
+// Distance from p to the segment ab
+double segmentDistance(const Point3D& p, const Point3D& a, const Point3D& b) {
+    Point3D ab = b - a;
+    Point3D ap = p - a;
+    double lengthSquared = ab.x * ab.x + ab.y * ab.y + ab.z * ab.z;
+    double t = lengthSquared > 0.0 ? (ap.x * ab.x + ap.y * ab.y + ap.z * ab.z) / lengthSquared : 0.0;
+    t = std::max(0.0, std::min(1.0, t));
+    return p.distance(a + ab * t);
+}
+
+// Part of the path on the positive side of the plane, ending on it
+std::vector<Point3D> clipPath(const std::vector<Point3D>& path, int axis) {
+    std::vector<Point3D> clipped;
+    for (size_t i = 0; i < path.size(); ++i) {
+        double c = axisValue(path[i], axis);
+        if (i > 0) {
+            double previous = axisValue(path[i - 1], axis);
+            if ((previous < 0.0) != (c < 0.0)) {
+                Point3D crossing = path[i - 1] + (path[i] - path[i - 1]) * (previous / (previous - c));
+                if (axis == 0) crossing.x = 0.0; else crossing.y = 0.0;
+                clipped.push_back(crossing);
+            }
+        }
+        if (c >= 0.0) clipped.push_back(path[i]);
+    }
+    return clipped;
+}
+
+} // namespace
+
+TubeCollapser::TubeCollapser(double maxDiameter)
+    : maxDiameter_(maxDiameter), minSlenderness_(5.0), mirrorAxis_(-1) {
+}
+
+TubeCollapser TubeCollapser::fromFrequency(const FrequencyCalculator& frequency, double divisions) {
+    if (!frequency.isValidFrequency() || divisions <= 0.0) {
+        return TubeCollapser();
+    }
+    return TubeCollapser(frequency.getWavelength() / divisions);
+}
+
+TubeSet TubeCollapser::collapse(const IndexedMesh& mesh, TubeReport* report) const {
+    TubeReport local;
+    TubeReport& result = report ? *report : local;
+    result = TubeReport();
+    result.inputFacets = mesh.faceCount();
+
+    TubeSet tubes;
+    if (mesh.faces.empty() || maxDiameter_ <= 0.0) {
+        tubes.remainder = mesh;
+        result.outputFacets = mesh.faceCount();
+        return tubes;
+    }
+
+    auto source = std::make_shared<ComponentMesh>();
+    source->mesh = mesh;
+    source->components = MeshTopology::findConnectedComponents(source->mesh);
+    std::vector<ComponentView> components = MeshTopology::componentViews(source);
+
+    // Same wire test as for antennas, with the tube limits
+    AntennaDetector detector;
+    detector.setMaxWireDiameter(maxDiameter_);
+    detector.setMinWireLength(minSlenderness_ * maxDiameter_ * 0.5);
+    detector.setMaxWireLength(1e6);
+    std::vector<AntennaWire> candidates = detector.detectWires(components);
+
+    // Slender, and a centerline the whole surface hugs; bent or branching
+    // parts sliced along one axis fail the second test
+    std::vector<uint8_t> accepted(candidates.size(), 0);
+    ThreadPool::getInstance().parallelFor(candidates.size(), [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            const AntennaWire& wire = candidates[c];
+            if (wire.path.size() < 2 || wire.length < minSlenderness_ * 2.0 * wire.radius) continue;
+
+            double reach = 2.0 * wire.radius + detector.getPathTolerance();
+            bool hugs = true;
+            for (uint32_t v : wire.component.vertexIds()) {
+                const Point3D& p = source->mesh.vertices[v];
+                double nearest = std::numeric_limits<double>::infinity();
+                for (size_t i = 1; i < wire.path.size() && nearest > reach; ++i) {
+                    nearest = std::min(nearest, segmentDistance(p, wire.path[i - 1], wire.path[i]));
+                }
+                if (nearest > reach) {
+                    hugs = false;
+                    break;
+                }
+            }
+            accepted[c] = hugs;
+        }
+    }, 16);
+
+    std::vector<uint8_t> removed(components.size(), 0);
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        if (!accepted[c]) continue;
+        const AntennaWire& wire = candidates[c];
+        std::vector<Point3D> path = wire.path;
+
+        if (mirrorAxis_ >= 0) {
+            double low = axisValue(path[0], mirrorAxis_);
+            double high = low;
+            for (const auto& p : path) {
+                low = std::min(low, axisValue(p, mirrorAxis_));
+                high = std::max(high, axisValue(p, mirrorAxis_));
+            }
+            // A wire in the plane would be reflected onto itself; one wholly
+            // behind it is cut away with the other half of the facets
+            if (std::max(-low, high) <= wire.radius) {
+                result.inPlaneTubes++;
+                continue;
+            }
+            if (high <= 0.0) continue;
+            if (low < 0.0) path = clipPath(path, mirrorAxis_);
+            if (path.size() < 2) continue;
+        }
+
+        uint32_t first = static_cast<uint32_t>(tubes.wires.nodes.size());
+        tubes.wires.nodes.insert(tubes.wires.nodes.end(), path.begin(), path.end());
+        for (uint32_t i = 1; i < path.size(); ++i) {
+            tubes.wires.edges.push_back({first + i - 1, first + i});
+            tubes.wires.edgeRadii.push_back(wire.radius);
+            result.totalLength += path[i - 1].distance(path[i]);
+        }
+        removed[wire.componentId] = 1;
+        result.tubes++;
+        result.tubeFacets += wire.component.size();
+    }
+    result.wires = tubes.wires.edgeCount();
+
+    if (result.tubes == 0) {
+        tubes.remainder = mesh;
+    } else {
+        std::vector<uint32_t> kept;
+        kept.reserve(mesh.faceCount() - result.tubeFacets);
+        for (uint32_t f = 0; f < mesh.faceCount(); ++f) {
+            if (!removed[source->components.faceComponent[f]]) kept.push_back(f);
+        }
+        tubes.remainder = MeshTopology::extractFaces(mesh, kept.data(), kept.data() + kept.size());
+    }
+    result.outputFacets = tubes.remainder.faceCount();
+    return tubes;
+}
+
+void TubeCollapser::printReport(const TubeReport& report) {
+    std::ostringstream text;
+    text << "\n=== Structural Tubes ===\n";
+    text << "Tubes replaced by centerline wires: " << report.tubes << " (" << report.tubeFacets << " facets)\n";
+    if (report.tubes > 0) {
+        text << "Wires: " << report.wires << ", total length " << std::fixed << std::setprecision(2)
+             << report.totalLength << " m\n";
+    }
+    if (report.inPlaneTubes > 0) {
+        text << "Tubes in the mirror plane kept as facets: " << report.inPlaneTubes << "\n";
+    }
+    text << "Facets: " << report.inputFacets << " -> " << report.outputFacets << "\n";
+    std::cout << text.str();
+}
+
+} // namespace stl_to_eznec
@@ -0,0 +1,149 @@
+#include "visibility_culler.h"
+#include "mesh_bvh.h"
+#include "thread_pool.h"
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace stl_to_eznec {
+
+namespace {
+
+// Evenly spread unit vectors (Fibonacci sphere)
+std::vector<Point3D> sphereDirections(unsigned count) {
+    std::vector<Point3D> directions(count);
+    double golden = M_PI * (3.0 - std::sqrt(5.0));
+    for (unsigned i = 0; i < count; ++i) {
+        double z = 1.0 - 2.0 * (i + 0.5) / count;
+        double r = std::sqrt(std::max(0.0, 1.0 - z * z));
+        directions[i] = Point3D(r * std::cos(golden * i), r * std::sin(golden * i), z);
+    }
+    return directions;
+}
+
+Point3D normalized(const Point3D& p) {
+    double length = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+    return length > 0.0 ? p * (1.0 / length) : Point3D(1, 0, 0);
+}
+
+Point3D cross(const Point3D& a, const Point3D& b) {
+    return Point3D(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+} // namespace
+
+VisibilityCuller::VisibilityCuller(double sampleSpacing)
+    : sampleSpacing_(sampleSpacing), directionCount_(64) {
+}
+
+VisibilityCuller VisibilityCuller::fromFrequency(const FrequencyCalculator& frequency, double divisions) {
+    if (!frequency.isValidFrequency() || divisions <= 0.0) {
+        return VisibilityCuller();
+    }
+    return VisibilityCuller(frequency.getWavelength() / divisions);
+}
+
+IndexedMesh VisibilityCuller::cull(const IndexedMesh& mesh, VisibilityReport* report) const {
+    VisibilityReport local;
+    VisibilityReport& result = report ? *report : local;
+    result = VisibilityReport();
+    result.inputFacets = mesh.faceCount();
+    if (mesh.faces.empty() || sampleSpacing_ <= 0.0 || directionCount_ == 0) return mesh;
+
+    MeshBVH bvh(mesh);
+    Point3D low = bvh.getMin();
+    Point3D high = bvh.getMax();
+    Point3D center = (low + high) * 0.5;
+    double radius = low.distance(high) * 0.5 + sampleSpacing_;
+
+    std::vector<Point3D> directions = sphereDirections(directionCount_);
+    std::vector<std::atomic<uint8_t>> visible(mesh.faceCount());
+    for (auto& flag : visible) {
+        flag.store(0, std::memory_order_relaxed);
+    }
+    std::atomic<size_t> rays(0);
+
+    // Inward pass: one grid row of parallel rays per work item
+    int rows = static_cast<int>(std::ceil(2.0 * radius / sampleSpacing_)) + 1;
+    ThreadPool::getInstance().parallelFor(directions.size() * rows, [&](size_t begin, size_t end) {
+        size_t cast = 0;
+        for (size_t item = begin; item < end; ++item) {
+            const Point3D& d = directions[item / rows];
+            Point3D u = normalized(cross(d, std::abs(d.z) < 0.9 ? Point3D(0, 0, 1) : Point3D(1, 0, 0)));
+            Point3D v = cross(d, u);
+            double a = -radius + static_cast<double>(item % rows) * sampleSpacing_;
+
+            for (int column = 0; column < rows; ++column) {
+                double b = -radius + column * sampleSpacing_;
+                if (a * a + b * b > radius * radius) continue;
+                Point3D origin = center + u * a + v * b - d * radius;
+                BVHHit hit = bvh.intersect(origin, d, 2.0 * radius);
+                cast++;
+                if (hit.found()) visible[hit.face].store(1, std::memory_order_relaxed);
+            }
+        }
+        rays += cast;
+    });
+
+    for (const auto& flag : visible) {
+        if (flag.load(std::memory_order_relaxed)) result.sphereHits++;
+    }
+
+    // Escape pass for facets the grid missed: any unobstructed ray from the
+    // facet to the sphere makes it exterior, whichever side it leaves from
+    ThreadPool::getInstance().parallelFor(mesh.faceCount(), [&](size_t begin, size_t end) {
+        size_t cast = 0;
+        for (size_t f = begin; f < end; ++f) {
+            if (visible[f].load(std::memory_order_relaxed)) continue;
+            const auto& face = mesh.faces[f];
+            const Point3D& a = mesh.vertices[face[0]];
+            Point3D centroid = (a + mesh.vertices[face[1]] + mesh.vertices[face[2]]) * (1.0 / 3.0);
+            Point3D normal = normalized(cross(mesh.vertices[face[1]] - a, mesh.vertices[face[2]] - a));
+
+            // Rays along either normal leave open surfaces soonest, so try them first
+            std::vector<std::pair<double, uint32_t>> order(directions.size());
+            for (uint32_t i = 0; i < directions.size(); ++i) {
+                const Point3D& d = directions[i];
+                order[i] = {-std::abs(d.x * normal.x + d.y * normal.y + d.z * normal.z), i};
+            }
+            std::sort(order.begin(), order.end());
+
+            for (const auto& entry : order) {
+                const Point3D& d = directions[entry.second];
+                cast++;
+                if (!bvh.occluded(centroid, d, 2.0 * radius, static_cast<int64_t>(f))) {
+                    visible[f].store(2, std::memory_order_relaxed);
+                    break;
+                }
+            }
+        }
+        rays += cast;
+    }, 256);
+
+    std::vector<uint32_t> kept;
+    kept.reserve(mesh.faceCount());
+    for (uint32_t f = 0; f < mesh.faceCount(); ++f) {
+        uint8_t flag = visible[f].load(std::memory_order_relaxed);
+        if (flag == 2) result.escapeHits++;
+        if (flag) {
+            kept.push_back(f);
+        } else {
+            result.hiddenFacets++;
+        }
+    }
+    result.raysCast = rays.load();
+
+    if (result.hiddenFacets == 0) return mesh;
+    return MeshTopology::extractFaces(mesh, kept.data(), kept.data() + kept.size());
+}
+
+void VisibilityCuller::printReport(const VisibilityReport& report) {
+    std::cout << "\n=== Exterior Visibility ===\n";
+    std::cout << "Rays cast: " << report.raysCast << "\n";
+    std::cout << "Visible from the enclosing sphere: " << report.sphereHits << " facets\n";
+    std::cout << "Visible through an escape ray: " << report.escapeHits << " facets\n";
+    std::cout << "Hidden facets removed: " << report.hiddenFacets << " of " << report.inputFacets << "\n";
+}
+
+} // namespace stl_to_eznec
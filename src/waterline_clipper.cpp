@@ -0,0 +1,112 @@
+#include "waterline_clipper.h"
+#include "thread_pool.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace stl_to_eznec {
+
+WaterlineClipper::WaterlineClipper(double freeboard)
+    : freeboard_(freeboard), hullSpanFraction_(0.9) {
+}
+
+double WaterlineClipper::estimateGunwaleHeight(const IndexedMesh& mesh, double hullSpanFraction) {
+    if (mesh.vertices.empty()) return 0.0;
+
+    Point3D low = mesh.vertices[0];
+    Point3D high = mesh.vertices[0];
+    for (const auto& v : mesh.vertices) {
+        low = Point3D(std::min(low.x, v.x), std::min(low.y, v.y), std::min(low.z, v.z));
+        high = Point3D(std::max(high.x, v.x), std::max(high.y, v.y), std::max(high.z, v.z));
+    }
+    double height = high.z - low.z;
+    if (height <= 0.0) return high.z;
+
+    // Hull length runs along the longer horizontal axis
+    bool alongX = high.x - low.x >= high.y - low.y;
+    double length = alongX ? high.x - low.x : high.y - low.y;
+
+    // Span of the facets crossing each horizontal slice
+    const int SLICES = 256;
+    std::vector<double> spanLow(SLICES, std::numeric_limits<double>::infinity());
+    std::vector<double> spanHigh(SLICES, -std::numeric_limits<double>::infinity());
+    for (const auto& face : mesh.faces) {
+        double zLow = mesh.vertices[face[0]].z, zHigh = zLow;
+        double sLow = alongX ? mesh.vertices[face[0]].x : mesh.vertices[face[0]].y, sHigh = sLow;
+        for (uint32_t v : face) {
+            const Point3D& p = mesh.vertices[v];
+            double s = alongX ? p.x : p.y;
+            zLow = std::min(zLow, p.z);
+            zHigh = std::max(zHigh, p.z);
+            sLow = std::min(sLow, s);
+            sHigh = std::max(sHigh, s);
+        }
+        int first = std::min(SLICES - 1, static_cast<int>((zLow - low.z) / height * SLICES));
+        int last = std::min(SLICES - 1, static_cast<int>((zHigh - low.z) / height * SLICES));
+        for (int slice = first; slice <= last; ++slice) {
+            spanLow[slice] = std::min(spanLow[slice], sLow);
+            spanHigh[slice] = std::max(spanHigh[slice], sHigh);
+        }
+    }
+
+    for (int slice = SLICES - 1; slice >= 0; --slice) {
+        if (spanHigh[slice] - spanLow[slice] >= hullSpanFraction * length) {
+            return low.z + height * (slice + 1) / SLICES;
+        }
+    }
+    return high.z;
+}
+
+IndexedMesh WaterlineClipper::clip(const IndexedMesh& mesh, WaterlineReport* report) const {
+    WaterlineReport local;
+    WaterlineReport& result = report ? *report : local;
+    result = WaterlineReport();
+    result.inputFacets = mesh.faceCount();
+    if (mesh.faces.empty()) return mesh;
+
+    double bottom = mesh.vertices[0].z;
+    for (const auto& v : mesh.vertices) {
+        bottom = std::min(bottom, v.z);
+    }
+    result.gunwaleZ = estimateGunwaleHeight(mesh, hullSpanFraction_);
+    result.waterlineZ = std::max(bottom, result.gunwaleZ - freeboard_);
+
+    for (const auto& face : mesh.faces) {
+        int above = 0;
+        for (uint32_t v : face) {
+            above += mesh.vertices[v].z >= result.waterlineZ ? 1 : 0;
+        }
+        if (above == 0) result.submergedFacets++;
+        if (above == 1 || above == 2) result.splitFacets++;
+    }
+
+    // The hull stays open: its wires end on the ground plane, where their
+    // image continues them, and a cap would lie in the plane itself
+    IndexedMesh clipped = MeshTopology::clipToHalfSpace(mesh, 2, result.waterlineZ);
+
+    // The water ground plane sits at z = 0
+    double shift = result.waterlineZ;
+    ThreadPool::getInstance().parallelFor(clipped.vertexCount(), [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            clipped.vertices[v].z -= shift;
+        }
+    }, 8192);
+
+    result.outputFacets = clipped.faceCount();
+    return clipped;
+}
+
+void WaterlineClipper::printReport(const WaterlineReport& report) {
+    std::ostringstream text;
+    text << "\n=== Waterline ===\n";
+    text << "Gunwale height: " << std::fixed << std::setprecision(2) << report.gunwaleZ << " m, waterline "
+         << report.waterlineZ << " m (moved to z = 0)\n";
+    text << "Submerged facets removed: " << report.submergedFacets << ", split: " << report.splitFacets << "\n";
+    text << "Facets: " << report.inputFacets << " -> " << report.outputFacets << "\n";
+    std::cout << text.str();
+}
+
+} // namespace stl_to_eznec
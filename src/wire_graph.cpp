@@ -0,0 +1,305 @@
+#include "wire_graph.h"
+#include "mesh_topology.h"
+#include <limits>
+
+namespace stl_to_eznec {
+
+namespace {
+
+// Switch to per-edge segment counts and radii once graphs with different
+// pitches or radii are combined
+void makePerEdge(WireGraph& graph, const WireGraph& added, bool& explicitSegments, bool& explicitRadii) {
+    explicitSegments = !graph.edgeSegments.empty() || !added.edgeSegments.empty() ||
+                       added.segmentLength != graph.segmentLength;
+    explicitRadii = !graph.edgeRadii.empty() || !added.edgeRadii.empty() || added.wireRadius != graph.wireRadius;
+    if (explicitSegments && graph.edgeSegments.empty()) {
+        std::vector<int> counts(graph.edges.size());
+        for (size_t e = 0; e < graph.edges.size(); ++e) {
+            counts[e] = graph.segmentCount(e);
+        }
+        graph.edgeSegments = std::move(counts);
+    }
+    if (explicitRadii && graph.edgeRadii.empty()) {
+        graph.edgeRadii.assign(graph.edges.size(), graph.wireRadius);
+    }
+}
+
+} // namespace
+
+WireGraph WireGraph::edgeRange(size_t begin, size_t end) const {
+    const uint32_t NONE = 0xFFFFFFFFu;
+    WireGraph result;
+    result.segmentLength = segmentLength;
+    result.wireRadius = wireRadius;
+    result.mirrorAxis = mirrorAxis;
+
+    std::vector<uint32_t> remap(nodes.size(), NONE);
+    for (size_t e = begin; e < end; ++e) {
+        std::array<uint32_t, 2> edge = edges[e];
+        for (auto& node : edge) {
+            if (remap[node] == NONE) {
+                remap[node] = static_cast<uint32_t>(result.nodes.size());
+                result.nodes.push_back(nodes[node]);
+            }
+            node = remap[node];
+        }
+        if (edge[0] > edge[1]) std::swap(edge[0], edge[1]);
+        result.edges.push_back(edge);
+        if (!edgeSegments.empty()) result.edgeSegments.push_back(edgeSegments[e]);
+        if (!edgeRadii.empty()) result.edgeRadii.push_back(edgeRadii[e]);
+    }
+    return result;
+}
+
+void WireGraph::appendReplicated(const WireGraph& prototype, int copies, double rotateZDegrees, const Point3D& translation) {
+    if (prototype.edges.empty()) return;
+
+    bool explicitSegments, explicitRadii;
+    makePerEdge(*this, prototype, explicitSegments, explicitRadii);
+
+    WireReplication replication;
+    replication.edgeBegin = edges.size();
+    replication.copies = copies;
+    replication.rotateZDegrees = rotateZDegrees;
+    replication.translation = translation;
+
+    uint32_t nodeOffset = static_cast<uint32_t>(nodes.size());
+    nodes.insert(nodes.end(), prototype.nodes.begin(), prototype.nodes.end());
+    for (size_t e = 0; e < prototype.edges.size(); ++e) {
+        edges.push_back({prototype.edges[e][0] + nodeOffset, prototype.edges[e][1] + nodeOffset});
+        if (explicitSegments) edgeSegments.push_back(prototype.segmentCount(e));
+        if (explicitRadii) edgeRadii.push_back(prototype.radius(e));
+    }
+
+    replication.edgeEnd = edges.size();
+    replications.push_back(replication);
+}
+
+void WireGraph::appendWires(const WireGraph& wires, double snapDistance) {
+    if (wires.edges.empty()) return;
+
+    bool explicitSegments, explicitRadii;
+    makePerEdge(*this, wires, explicitSegments, explicitRadii);
+
+    // Only the free ends of the added wires are joined to the grid
+    std::vector<uint32_t> degree(wires.nodes.size(), 0);
+    for (const auto& edge : wires.edges) {
+        degree[edge[0]]++;
+        degree[edge[1]]++;
+    }
+    size_t base = baseEdgeCount();
+    std::vector<uint8_t> baseNode(nodes.size(), 0);
+    for (size_t e = 0; e < base; ++e) {
+        baseNode[edges[e][0]] = 1;
+        baseNode[edges[e][1]] = 1;
+    }
+
+    // Base nodes hashed at the snap distance, so each end looks only at
+    // the cells around it
+    SpatialHash baseNodes(snapDistance);
+    if (snapDistance > 0.0) {
+        for (uint32_t m = 0; m < baseNode.size(); ++m) {
+            if (baseNode[m]) baseNodes.insert(nodes[m], m);
+        }
+    }
+
+    std::vector<uint32_t> remap(wires.nodes.size());
+    for (uint32_t n = 0; n < wires.nodes.size(); ++n) {
+        int64_t nearest = -1;
+        if (degree[n] == 1 && snapDistance > 0.0) {
+            nearest = baseNodes.findNearest(wires.nodes[n], snapDistance);
+        }
+        if (nearest < 0) {
+            nearest = static_cast<int64_t>(nodes.size());
+            nodes.push_back(wires.nodes[n]);
+        }
+        remap[n] = static_cast<uint32_t>(nearest);
+    }
+
+    // New edges go after the base edges, ahead of any replicated ranges
+    std::vector<std::array<uint32_t, 2>> added;
+    std::vector<int> addedSegments;
+    std::vector<double> addedRadii;
+    for (size_t e = 0; e < wires.edges.size(); ++e) {
+        uint32_t a = remap[wires.edges[e][0]];
+        uint32_t b = remap[wires.edges[e][1]];
+        if (a == b) continue;
+        added.push_back({std::min(a, b), std::max(a, b)});
+        if (explicitSegments) addedSegments.push_back(wires.segmentCount(e));
+        if (explicitRadii) addedRadii.push_back(wires.radius(e));
+    }
+    edges.insert(edges.begin() + base, added.begin(), added.end());
+    if (explicitSegments) edgeSegments.insert(edgeSegments.begin() + base, addedSegments.begin(), addedSegments.end());
+    if (explicitRadii) edgeRadii.insert(edgeRadii.begin() + base, addedRadii.begin(), addedRadii.end());
+    for (auto& replication : replications) {
+        replication.edgeBegin += added.size();
+        replication.edgeEnd += added.size();
+    }
+}
+
+uint32_t WireGraph::joinPoint(const Point3D& point, double snapDistance) {
+    const uint32_t NONE = 0xFFFFFFFFu;
+    auto dot = [](const Point3D& a, const Point3D& b) { return a.x * b.x + a.y * b.y + a.z * b.z; };
+
+    size_t base = baseEdgeCount();
+    uint32_t nearestNode = NONE;
+    double nodeDistance = std::numeric_limits<double>::infinity();
+    size_t nearestEdge = base;
+    double edgeDistance = std::numeric_limits<double>::infinity();
+    double edgeT = 0.0;
+    for (size_t e = 0; e < base; ++e) {
+        for (uint32_t node : edges[e]) {
+            double distance = nodes[node].distance(point);
+            if (distance < nodeDistance) {
+                nearestNode = node;
+                nodeDistance = distance;
+            }
+        }
+        Point3D along = edgeEnd(e) - edgeStart(e);
+        double lengthSquared = dot(along, along);
+        if (lengthSquared <= 0.0) continue;
+        double t = std::max(0.0, std::min(1.0, dot(point - edgeStart(e), along) / lengthSquared));
+        double distance = (edgeStart(e) + along * t).distance(point);
+        if (distance < edgeDistance) {
+            nearestEdge = e;
+            edgeDistance = distance;
+            edgeT = t;
+        }
+    }
+    if (nodeDistance <= snapDistance) return nearestNode;
+    if (edgeDistance > snapDistance) return NONE;
+
+    // Split the wire at the foot of the perpendicular; the second piece
+    // joins the base edges, ahead of any replicated ranges
+    std::array<uint32_t, 2> edge = edges[nearestEdge];
+    uint32_t node = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(nodes[edge[0]] + (nodes[edge[1]] - nodes[edge[0]]) * edgeT);
+    edges[nearestEdge] = {edge[0], node};
+    edges.insert(edges.begin() + base, {edge[1], node});
+    if (!edgeSegments.empty()) {
+        int total = edgeSegments[nearestEdge];
+        int first = std::max(1, static_cast<int>(std::lround(total * edgeT)));
+        edgeSegments[nearestEdge] = first;
+        edgeSegments.insert(edgeSegments.begin() + base, std::max(1, total - first));
+    }
+    if (!edgeRadii.empty()) {
+        edgeRadii.insert(edgeRadii.begin() + base, edgeRadii[nearestEdge]);
+    }
+    for (auto& replication : replications) {
+        replication.edgeBegin++;
+        replication.edgeEnd++;
+    }
+    return node;
+}
+
+WireGraph WireGraph::mergeCollinearChains(double angleToleranceDegrees) const {
+    if (!replications.empty()) {
+        WireGraph result = edgeRange(0, baseEdgeCount()).mergeCollinearChains(angleToleranceDegrees);
+        for (const auto& replication : replications) {
+            result.appendReplicated(edgeRange(replication.edgeBegin, replication.edgeEnd).mergeCollinearChains(angleToleranceDegrees),
+                                    replication.copies, replication.rotateZDegrees, replication.translation);
+        }
+        return result;
+    }
+
+    WireGraph result;
+    result.segmentLength = segmentLength;
+    result.wireRadius = wireRadius;
+    result.mirrorAxis = mirrorAxis;
+    if (edges.empty()) return result;
+
+    const uint32_t NONE = 0xFFFFFFFFu;
+    double cosTolerance = std::cos(angleToleranceDegrees * M_PI / 180.0);
+
+    auto direction = [this](uint32_t from, uint32_t to) {
+        Point3D d = nodes[to] - nodes[from];
+        double length = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+        return length > 0.0 ? d * (1.0 / length) : Point3D();
+    };
+    auto dot = [](const Point3D& a, const Point3D& b) { return a.x * b.x + a.y * b.y + a.z * b.z; };
+
+    // Node-edge incidence in CSR form
+    std::vector<uint32_t> offsets(nodes.size() + 1, 0);
+    for (const auto& edge : edges) {
+        offsets[edge[0] + 1]++;
+        offsets[edge[1] + 1]++;
+    }
+    for (size_t n = 0; n < nodes.size(); ++n) {
+        offsets[n + 1] += offsets[n];
+    }
+    std::vector<uint32_t> incident(offsets.back());
+    std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (uint32_t e = 0; e < edges.size(); ++e) {
+        incident[cursor[edges[e][0]]++] = e;
+        incident[cursor[edges[e][1]]++] = e;
+    }
+
+    auto otherEnd = [this](uint32_t e, uint32_t node) { return edges[e][0] == node ? edges[e][1] : edges[e][0]; };
+
+    // A node can be dissolved when exactly two edges of one radius meet there nearly head-on
+    std::vector<uint8_t> passThrough(nodes.size(), 0);
+    for (uint32_t n = 0; n < nodes.size(); ++n) {
+        if (offsets[n + 1] - offsets[n] != 2) continue;
+        uint32_t e0 = incident[offsets[n]];
+        uint32_t e1 = incident[offsets[n] + 1];
+        if (radius(e0) != radius(e1)) continue;
+        uint32_t a = otherEnd(e0, n);
+        uint32_t b = otherEnd(e1, n);
+        passThrough[n] = dot(direction(a, n), direction(n, b)) >= cosTolerance;
+    }
+
+    std::vector<uint8_t> visited(edges.size(), 0);
+    std::vector<uint32_t> remap(nodes.size(), NONE);
+    auto emitNode = [&](uint32_t n) {
+        if (remap[n] == NONE) {
+            remap[n] = static_cast<uint32_t>(result.nodes.size());
+            result.nodes.push_back(nodes[n]);
+        }
+        return remap[n];
+    };
+
+    auto walk = [&](uint32_t start, uint32_t firstEdge) {
+        visited[firstEdge] = 1;
+        int segments = segmentCount(firstEdge);
+        uint32_t previous = firstEdge;
+        uint32_t current = otherEnd(firstEdge, start);
+        Point3D chord = direction(start, current);
+
+        // Compare each step with the first edge so slow curves are not flattened
+        while (passThrough[current]) {
+            uint32_t e0 = incident[offsets[current]];
+            uint32_t e1 = incident[offsets[current] + 1];
+            uint32_t next = e0 == previous ? e1 : e0;
+            if (visited[next]) break;
+
+            uint32_t nextNode = otherEnd(next, current);
+            if (dot(chord, direction(current, nextNode)) < cosTolerance) break;
+
+            visited[next] = 1;
+            segments += segmentCount(next);
+            previous = next;
+            current = nextNode;
+        }
+
+        uint32_t a = emitNode(start);
+        uint32_t b = emitNode(current);
+        result.edges.push_back({std::min(a, b), std::max(a, b)});
+        result.edgeSegments.push_back(segments);
+        if (!edgeRadii.empty()) result.edgeRadii.push_back(edgeRadii[firstEdge]);
+    };
+
+    // Chains start at junctions and ends first; what is left are closed loops
+    // or chains split by the straightness check
+    for (int pass = 0; pass < 2; ++pass) {
+        for (uint32_t n = 0; n < nodes.size(); ++n) {
+            if (pass == 0 && passThrough[n]) continue;
+            for (uint32_t i = offsets[n]; i < offsets[n + 1]; ++i) {
+                if (!visited[incident[i]]) walk(n, incident[i]);
+            }
+        }
+    }
+
+    return result;
+}
+
+} // namespace stl_to_eznec
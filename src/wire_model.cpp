@@ -0,0 +1,244 @@
+#include "wire_model.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace stl_to_eznec {
+
+namespace {
+
+int calculateSegments(double length, double gridSpacing) {
+    if (gridSpacing <= 0) return 1;
+    return std::max(1, static_cast<int>(std::ceil(length / gridSpacing)));
+}
+
+// One wire per centerline piece, segmented by its own length at 5 cm and
+// odd for a centre feed
+int antennaSegments(const AntennaWire& antenna, size_t piece) {
+    int segments = calculateSegments(antenna.path[piece - 1].distance(antenna.path[piece]), 0.05);
+    if (segments % 2 == 0) segments++;
+    return segments;
+}
+
+void appendAntenna(WireModel& model, const AntennaWire& antenna) {
+    if (!antenna.isDetected || antenna.path.size() < 2) return;
+
+    for (size_t i = 1; i < antenna.path.size(); ++i) {
+        model.wires.push_back(NECWire(++model.tagCount, antennaSegments(antenna, i), antenna.path[i-1],
+                                      antenna.path[i], antenna.radius));
+    }
+    model.antennaWires = model.wires.size();
+}
+
+void appendStructure(WireModel& model, const WireGraph& structure) {
+    // Every edge takes one tag, and the last edge of a prototype also
+    // reserves the tags of its copies
+    std::vector<size_t> prototypeEnd;
+    std::vector<int> copyTags;
+    for (const auto& replication : structure.replications) {
+        prototypeEnd.push_back(replication.edgeEnd);
+        copyTags.push_back(static_cast<int>(replication.edgeEnd - replication.edgeBegin) * replication.copies);
+    }
+
+    // Tags from a prefix sum over chunks: count each chunk's tags, scan the
+    // counts, then number each chunk from its offset. Chunks depend on the
+    // thread count; the tags do not.
+    const size_t MIN_CHUNK = 4096;
+    ThreadPool& pool = ThreadPool::getInstance();
+    size_t edgeCount = structure.edgeCount();
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(pool.getThreadCount() * 4, edgeCount / MIN_CHUNK));
+    auto chunkBegin = [edgeCount, chunkCount](size_t chunk) { return edgeCount * chunk / chunkCount; };
+    auto firstPrototype = [&prototypeEnd](size_t edge) {
+        // First prototype whose last edge is at or after edge
+        return std::upper_bound(prototypeEnd.begin(), prototypeEnd.end(), edge) - prototypeEnd.begin();
+    };
+
+    std::vector<int> chunkTags(chunkCount + 1, 0);
+    pool.parallelFor(chunkCount, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            size_t end = chunkBegin(c + 1);
+            int tags = static_cast<int>(end - chunkBegin(c));
+            for (size_t r = firstPrototype(chunkBegin(c)); r < prototypeEnd.size() && prototypeEnd[r] <= end; ++r) {
+                tags += copyTags[r];
+            }
+            chunkTags[c + 1] = tags;
+        }
+    }, 1);
+    chunkTags[0] = model.tagCount + 1;
+    for (size_t c = 0; c < chunkCount; ++c) {
+        chunkTags[c + 1] += chunkTags[c];
+    }
+
+    size_t first = model.wires.size();
+    model.wires.resize(first + edgeCount);
+    pool.parallelFor(chunkCount, [&](size_t firstChunk, size_t lastChunk) {
+        for (size_t c = firstChunk; c < lastChunk; ++c) {
+            int tag = chunkTags[c];
+            size_t r = firstPrototype(chunkBegin(c));
+            for (size_t e = chunkBegin(c); e < chunkBegin(c + 1); ++e) {
+                model.wires.set(first + e, NECWire(tag++, structure.segmentCount(e), structure.edgeStart(e),
+                                                   structure.edgeEnd(e), structure.radius(e)));
+                while (r < prototypeEnd.size() && prototypeEnd[r] == e + 1) {
+                    tag += copyTags[r++];
+                }
+            }
+        }
+    }, 1);
+
+    // GR turns everything defined so far, so it only fits a ring about the
+    // z axis that is the first geometry in the deck
+    bool firstWires = first == 0;
+    for (const auto& replication : structure.replications) {
+        ModelReplication copy;
+        copy.wireBegin = first + replication.edgeBegin;
+        copy.wireEnd = first + replication.edgeEnd;
+        copy.copies = replication.copies;
+        copy.rotateZDegrees = replication.rotateZDegrees;
+        copy.translation = replication.translation;
+
+        bool fullTurn = replication.rotateZDegrees > 0.0 &&
+                        std::abs(replication.rotateZDegrees * (replication.copies + 1) - 360.0) < 1e-6;
+        bool aboutAxis = replication.translation.distance(Point3D(0, 0, 0)) < 1e-6;
+        copy.rotational = firstWires && replication.edgeBegin == 0 && fullTurn && aboutAxis;
+        model.replications.push_back(copy);
+    }
+    model.tagCount = chunkTags[chunkCount] - 1;
+
+    // The base wires go along a Morton curve through their midpoints, so
+    // wires that meet sit near each other in the deck; their tags stay in
+    // array order. Prototypes keep theirs, since GM copies them by tag range.
+    size_t baseEnd = first + structure.baseEdgeCount();
+    model.wires.sortByLocality(first, baseEnd);
+    std::sort(model.wires.tags.begin() + first, model.wires.tags.begin() + baseEnd);
+}
+
+} // namespace
+
+WireModel WireModel::build(
+    const WireGraph& structure,
+    const MaterialProperties& material,
+    const FrequencyCalculator& frequency,
+    const AntennaWire& antenna,
+    const std::string& modelName,
+    bool hasAntenna,
+    double waterlineHeight,
+    const WaterProperties* water) {
+
+    WireModel model;
+    model.modelName = modelName;
+    model.material = material;
+    model.frequency = frequency;
+
+    // Antenna wires first, one tag per path piece starting at 1
+    bool antennaWritten = hasAntenna && antenna.isDetected;
+    if (antennaWritten) {
+        appendAntenna(model, antenna);
+    }
+    appendStructure(model, structure);
+
+    // GX would reflect the antenna as well, so it is only used without one
+    if (!antennaWritten) {
+        model.mirrorAxis = structure.mirrorAxis;
+    }
+
+    // Feed the segment whose centre lies closest to the feed point
+    if (antennaWritten && antenna.path.size() >= 2) {
+        int feedTag = 1;
+        int feedSegment = 1;
+        double closest = -1.0;
+
+        for (size_t i = 1; i < antenna.path.size(); ++i) {
+            const Point3D& start = antenna.path[i-1];
+            const Point3D& end = antenna.path[i];
+            int segments = antennaSegments(antenna, i);
+
+            for (int segment = 1; segment <= segments; ++segment) {
+                Point3D centre = start + (end - start) * ((segment - 0.5) / segments);
+                double distance = centre.distance(antenna.feedPoint);
+                if (closest < 0 || distance < closest) {
+                    closest = distance;
+                    feedTag = static_cast<int>(i);
+                    feedSegment = segment;
+                }
+            }
+        }
+        model.excitations.emplace_back(feedTag, feedSegment);
+    }
+
+    // Marine ground with water properties, otherwise perfect ground
+    if (waterlineHeight > 0 && water != nullptr) {
+        model.groundType = 2;
+        model.groundPermittivity = water->relativePermittivity;
+        model.groundConductivity = water->conductivity;
+    }
+
+    return model;
+}
+
+WireModel WireModel::buildStructureOnly(
+    const WireGraph& structure,
+    const MaterialProperties& material,
+    const std::string& modelName) {
+
+    WireModel model;
+    model.modelName = modelName;
+    model.material = material;
+    model.structureOnly = true;
+    appendStructure(model, structure);
+    model.mirrorAxis = structure.mirrorAxis;
+    return model;
+}
+
+WireGraph WireModel::buildEdgeWires(const std::vector<Triangle>& triangles) {
+    // Facet edges as wires, each shared edge written once
+    WireGraph edges = MeshTopology::buildEdgeGraph(MeshTopology::buildIndexedMesh(triangles));
+    edges.segmentLength = 0.1; // 10cm grid spacing for structure
+
+    return edges.mergeCollinearChains();
+}
+
+void WireModel::setSurfacePatches(const IndexedMesh& patchMesh, const WireGraph& standIn) {
+    patches = patchMesh;
+    patchWires.clear();
+    patchWires.reserve(standIn.edgeCount());
+    for (size_t e = 0; e < standIn.edgeCount(); ++e) {
+        patchWires.push_back(NECWire(0, standIn.segmentCount(e), standIn.edgeStart(e), standIn.edgeEnd(e),
+                                     standIn.radius(e)));
+    }
+
+    // Wires between coincident nodes carry no current; the rest are
+    // ordered along a Morton curve and tagged after the structure
+    patchWires.filter([this](size_t i) { return patchWires.starts[i].distance(patchWires.ends[i]) > 0.0; });
+    patchWires.sortByLocality();
+    patchWires.renumber(tagCount + 1);
+}
+
+size_t WireModel::cardCount(bool withPatches) const {
+    // One card per wire, replication, source and load, two per patch, and a
+    // few dozen header and control cards
+    size_t cards = wires.size() + replications.size() + excitations.size() + loads.size() + 32;
+    cards += withPatches ? 2 * patches.faceCount() : patchWires.size();
+    return cards;
+}
+
+size_t WireModel::solverUnknowns() const {
+    size_t unknowns = 0;
+    for (int segments : wires.segments) {
+        unknowns += segments;
+    }
+    for (const auto& replication : replications) {
+        size_t prototype = 0;
+        for (size_t w = replication.wireBegin; w < replication.wireEnd; ++w) {
+            prototype += wires.segments[w];
+        }
+        unknowns += prototype * replication.copies;
+    }
+    size_t standIn = 0;
+    for (int segments : patchWires.segments) {
+        standIn += segments;
+    }
+    unknowns += std::max(2 * patches.faceCount(), standIn);
+    return mirrorAxis >= 0 ? 2 * unknowns : unknowns;
+}
+
+} // namespace stl_to_eznec
@@ -0,0 +1,141 @@
+#include "wire_skeleton.h"
+#include "covariance_accumulator.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace stl_to_eznec {
+
+WireCenterline WireSkeleton::extractCenterline(const std::vector<Triangle>& triangles) {
+    // Weld first so every vertex is counted once per ring
+    IndexedMesh mesh = MeshTopology::buildIndexedMesh(triangles);
+    return extractCenterline(mesh.vertices);
+}
+
+WireCenterline WireSkeleton::extractCenterline(const ComponentView& component) {
+    std::vector<Point3D> vertices;
+    if (component.empty()) return WireCenterline();
+
+    std::vector<uint32_t> ids = component.vertexIds();
+    vertices.reserve(ids.size());
+    for (uint32_t id : ids) {
+        vertices.push_back(component.mesh().vertices[id]);
+    }
+    return extractCenterline(vertices);
+}
+
+WireCenterline WireSkeleton::extractCenterline(const std::vector<Point3D>& vertices) {
+    WireCenterline centerline;
+
+    if (vertices.size() < 3) {
+        centerline.path = vertices;
+        centerline.ringCount = static_cast<int>(vertices.size());
+        return centerline;
+    }
+
+    CovarianceAccumulator accumulator;
+    for (const auto& vertex : vertices) {
+        accumulator.addPoint(vertex);
+    }
+    OrientedExtents extents = accumulator.getOrientedExtents();
+    Point3D mean = extents.center;
+    Point3D axis = extents.principalAxis();
+    double crossSectionVariance = extents.variances[1] + extents.variances[2];
+    centerline.axis = axis;
+
+    // Position of every vertex along the axis
+    std::vector<double> t(vertices.size());
+    double tMin = std::numeric_limits<double>::max();
+    double tMax = std::numeric_limits<double>::lowest();
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        Point3D d = vertices[i] - mean;
+        t[i] = d.x * axis.x + d.y * axis.y + d.z * axis.z;
+        tMin = std::min(tMin, t[i]);
+        tMax = std::max(tMax, t[i]);
+    }
+
+    double span = tMax - tMin;
+    if (span <= 0.0) {
+        centerline.path.push_back(mean);
+        centerline.ringCount = 1;
+        return centerline;
+    }
+
+    // For points spread on a circle the two minor variances sum to r^2
+    double crossRadius = std::sqrt(std::max(crossSectionVariance, 0.0));
+    double gapTolerance = 0.25 * crossRadius;
+    double maxRingWidth = crossRadius > 0.0 ? 2.0 * crossRadius : span;
+
+    // Bucket vertices along the axis; linear in the vertex count
+    size_t binCount = std::min<size_t>(std::max<size_t>(vertices.size() * 4, 16), size_t(1) << 22);
+    double binWidth = span / binCount;
+    std::vector<uint32_t> vertexBin(vertices.size());
+    std::vector<uint8_t> occupied(binCount, 0);
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        size_t bin = std::min(static_cast<size_t>((t[i] - tMin) / binWidth), binCount - 1);
+        vertexBin[i] = static_cast<uint32_t>(bin);
+        occupied[bin] = 1;
+    }
+
+    // A ring is a run of occupied bins; a gap wider than the tolerance starts a
+    // new ring, and runs wider than the tube diameter are split
+    std::vector<int32_t> binRing(binCount, -1);
+    int32_t ringCount = 0;
+    double ringStart = 0.0;
+    double lastOccupied = -std::numeric_limits<double>::max();
+
+    for (size_t bin = 0; bin < binCount; ++bin) {
+        if (!occupied[bin]) continue;
+
+        double binStart = bin * binWidth;
+        bool newRing = ringCount == 0 ||
+                       binStart - lastOccupied > gapTolerance + binWidth ||
+                       binStart - ringStart >= maxRingWidth;
+        if (newRing) {
+            ringStart = binStart;
+            ringCount++;
+        }
+        binRing[bin] = ringCount - 1;
+        lastOccupied = binStart;
+    }
+
+    std::vector<Point3D> ringSum(ringCount, Point3D(0, 0, 0));
+    std::vector<int> ringSize(ringCount, 0);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        int32_t ring = binRing[vertexBin[i]];
+        ringSum[ring] = ringSum[ring] + vertices[i];
+        ringSize[ring]++;
+    }
+
+    centerline.path.reserve(ringCount);
+    for (int32_t r = 0; r < ringCount; ++r) {
+        centerline.path.push_back(ringSum[r] * (1.0 / ringSize[r]));
+    }
+    centerline.ringCount = ringCount;
+
+    // Ring radius is the mean distance from the ring centre, perpendicular to the axis
+    std::vector<double> ringRadius(ringCount, 0.0);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        int32_t ring = binRing[vertexBin[i]];
+        Point3D d = vertices[i] - centerline.path[ring];
+        double along = d.x * axis.x + d.y * axis.y + d.z * axis.z;
+        double squared = d.x*d.x + d.y*d.y + d.z*d.z - along * along;
+        ringRadius[ring] += std::sqrt(std::max(squared, 0.0));
+    }
+
+    // End caps and other degenerate rings do not describe the tube wall
+    double radiusSum = 0.0;
+    int radiusRings = 0;
+    for (int32_t r = 0; r < ringCount; ++r) {
+        if (ringSize[r] >= 3) {
+            radiusSum += ringRadius[r] / ringSize[r];
+            radiusRings++;
+        }
+    }
+    centerline.radius = radiusRings > 0 ? radiusSum / radiusRings : crossRadius;
+
+    return centerline;
+}
+
+} // namespace stl_to_eznec